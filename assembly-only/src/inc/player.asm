@@ -0,0 +1,250 @@
+; ************************************
+; Data-table music player
+; ************************************
+; Call PlayerUpdate from VBlankInterrupt and start a song with PlayerInit.
+; The including ROM must define player_ram, PlayerChannelCount*ch_size
+; bytes of RAM for the channel state. FM channels need the Z80 bus held
+; (see SuspendZ80) and their patches loaded by the ROM.
+;
+; A song is PlayerChannelCount longword stream pointers (0 = unused), for
+; PSG tone 0-2, PSG noise, then FM 1-6. Each stream is a string of bytes:
+;   0x00-0x7F : Note, octave in bits 6-4 and semitone (C = 0) in bits 3-0.
+;               PSG tone channels cover C3 to B7, as the tone counter is
+;               only 10 bits; FM channels use the octave as the block.
+;               Semitones 12-15, and PSG octaves below 3, play as rests.
+;               On the noise channel bits 2-0 are the noise mode instead.
+;   0x80-0xBF : Set the duration of following notes to (bits 5-0) + 1 frames
+;   0xC0      : Rest for the current duration
+;   0xD0-0xDF : Set PSG attenuation to bits 3-0 (0 = loudest)
+;   0xFE      : Loop back to the start of the stream
+;   0xFF      : End of stream
+; Each channel has a countdown timer, so a channel only decodes bytes on the
+; frame its current note or rest runs out.
+
+PlayerPsgPort		equ 0x00C00011
+PlayerFm1Port		equ 0x00A04000
+PlayerFm2Port		equ 0x00A04002
+
+PlayerChannelCount	equ 10
+PlayerNoiseChannel	equ 3
+PlayerFmChannel		equ 4
+PlayerPsgTopOctave	equ 3
+
+ch_ptr			equ 0			; Next stream byte (0 = not playing)
+ch_start		equ 4			; Start of stream, for looping
+ch_timer		equ 8			; Frames left of the current note or rest
+ch_duration		equ 9			; Frames per note or rest
+ch_volume		equ 10			; PSG attenuation
+ch_size			equ 12
+
+PlayerInit:
+	; a0 - Song
+	move.w	sr, -(sp)		; Keep VBlank out while the channels are set up
+	move.w	#0x2700, sr
+	lea	player_ram, a1
+	move.w	#PlayerChannelCount-1, d0
+	@Channel:
+	move.l	(a0), ch_ptr(a1)
+	move.l	(a0)+, ch_start(a1)
+	move.b	#0x1, ch_timer(a1)	; Decode the first bytes on the next frame
+	move.b	#0x1, ch_duration(a1)
+	move.b	#0x0, ch_volume(a1)
+	adda.w	#ch_size, a1
+	dbra	d0, @Channel
+	move.w	(sp)+, sr
+	rts
+
+PlayerUpdate:
+	movem.l	d0-d3/d7/a0-a2, -(sp)
+	lea	player_ram, a1
+	moveq	#0x0, d7		; Channel index
+	@Channel:
+	move.l	ch_ptr(a1), d0
+	beq	@Next			; Channel not playing
+	subq.b	#0x1, ch_timer(a1)
+	bne	@Next			; Current note still running
+	movea.l	d0, a0
+
+	@Read:
+	moveq	#0x0, d1
+	move.b	(a0)+, d1
+	cmpi.b	#0x80, d1
+	bcs	@Note			; 0x00-0x7F
+	cmpi.b	#0xC0, d1
+	bcs	@Duration		; 0x80-0xBF
+	beq	@Rest			; 0xC0
+	cmpi.b	#0xD0, d1
+	bcs	@Read			; 0xC1-0xCF unused
+	cmpi.b	#0xE0, d1
+	bcs	@Volume			; 0xD0-0xDF
+	cmpi.b	#0xFE, d1
+	beq	@Loop
+
+	jsr	PlayerSilence		; End of stream
+	clr.l	ch_ptr(a1)
+	bra	@Next
+
+	@Duration:
+	andi.b	#0x3F, d1
+	addq.b	#0x1, d1
+	move.b	d1, ch_duration(a1)
+	bra	@Read
+
+	@Volume:
+	andi.b	#0x0F, d1
+	move.b	d1, ch_volume(a1)
+	bra	@Read
+
+	@Loop:
+	movea.l	ch_start(a1), a0
+	bra	@Read
+
+	@Rest:
+	jsr	PlayerSilence
+	bra	@Wait
+
+	@Note:
+	jsr	PlayerNote
+
+	@Wait:
+	move.b	ch_duration(a1), ch_timer(a1)
+	move.l	a0, ch_ptr(a1)
+
+	@Next:
+	adda.w	#ch_size, a1
+	addq.b	#0x1, d7
+	cmpi.b	#PlayerChannelCount, d7
+	bne	@Channel
+	movem.l	(sp)+, d0-d3/d7/a0-a2
+	rts
+
+PlayerNote:
+	; d1 - Note byte, d7 - Channel index, a1 - Channel state
+	cmpi.b	#PlayerFmChannel, d7
+	bcc	PlayerFmNote
+	cmpi.b	#PlayerNoiseChannel, d7
+	beq	@Noise
+
+	move.b	d1, d2			; PSG counter for the semitone in the top octave
+	andi.w	#0x000F, d2
+	cmpi.b	#0xB, d2
+	bhi	PlayerSilence		; Not a semitone
+	add.w	d2, d2
+	lea	PlayerPsgCounters, a2
+	move.w	(a2,d2.w), d2
+	lsr.b	#0x4, d1		; Halve it for each octave above
+	subq.b	#PlayerPsgTopOctave, d1
+	bcs	PlayerSilence		; Below the lowest octave
+	lsr.w	d1, d2
+
+	move.b	d7, d3			; Latch, channel and low 4 bits of the counter
+	lsl.b	#0x5, d3
+	move.b	d2, d0
+	andi.b	#0x0F, d0
+	or.b	d3, d0
+	ori.b	#0x80, d0
+	move.b	d0, PlayerPsgPort
+	lsr.w	#0x4, d2		; High 6 bits of the counter
+	andi.b	#0x3F, d2
+	move.b	d2, PlayerPsgPort
+	bra	PlayerVolume
+
+	@Noise:
+	andi.b	#0x07, d1
+	ori.b	#0xE0, d1
+	move.b	d1, PlayerPsgPort
+
+PlayerVolume:
+	; d7 - PSG channel index, a1 - Channel state
+	move.b	d7, d0
+	lsl.b	#0x5, d0
+	or.b	ch_volume(a1), d0
+	ori.b	#0x90, d0
+	move.b	d0, PlayerPsgPort
+	rts
+
+PlayerSilence:
+	; d7 - Channel index
+	cmpi.b	#PlayerFmChannel, d7
+	bcc	PlayerFmKeyOff
+	move.b	d7, d0
+	lsl.b	#0x5, d0
+	ori.b	#0x9F, d0		; Full attenuation
+	move.b	d0, PlayerPsgPort
+	rts
+
+PlayerFmNote:
+	; d1 - Note byte, d7 - Channel index
+	move.b	d1, d0
+	andi.b	#0x0F, d0
+	cmpi.b	#0xB, d0
+	bhi	PlayerFmKeyOff		; Not a semitone
+	jsr	PlayerFmKeyOff
+	move.b	d1, d2			; F-number for the semitone
+	andi.w	#0x000F, d2
+	add.w	d2, d2
+	lea	PlayerFmFrequencies, a2
+	move.w	(a2,d2.w), d3
+	lsr.b	#0x4, d1		; Block and top 3 bits of the F-number
+	lsl.b	#0x3, d1
+	move.w	d3, d2
+	lsr.w	#0x8, d2
+	or.b	d1, d2
+
+	move.b	d7, d0			; Port and register offset for the channel
+	subq.b	#PlayerFmChannel, d0
+	lea	PlayerFm1Port, a2
+	cmpi.b	#0x3, d0
+	bcs	@Part1
+	subq.b	#0x3, d0
+	lea	PlayerFm2Port, a2
+	@Part1:
+	move.b	d0, d1
+	addi.b	#0xA4, d0
+	jsr	PlayerWriteFm
+	move.b	d1, d0
+	addi.b	#0xA0, d0
+	move.b	d3, d2
+	jsr	PlayerWriteFm
+
+	jsr	PlayerFmKeyCode		; Key on all operators
+	move.b	d0, d2
+	ori.b	#0xF0, d2
+	move.b	#0x28, d0
+	lea	PlayerFm1Port, a2
+	bra	PlayerWriteFm
+
+PlayerFmKeyOff:
+	; d7 - Channel index
+	jsr	PlayerFmKeyCode
+	move.b	d0, d2
+	move.b	#0x28, d0
+	lea	PlayerFm1Port, a2
+	bra	PlayerWriteFm
+
+PlayerFmKeyCode:
+	; d7 - Channel index, returns the 0x28 channel code in d0
+	move.b	d7, d0
+	subq.b	#PlayerFmChannel, d0
+	cmpi.b	#0x3, d0
+	bcs	@Done
+	addq.b	#0x1, d0		; Channels 4-6 are codes 4-6
+	@Done:
+	rts
+
+PlayerWriteFm:
+	; a2 - FM address port, d0 - Register, d2 - Data
+	@Wait:
+	btst	#0x7, PlayerFm1Port	; Wait while the FM chip is busy
+	bne	@Wait
+	move.b	d0, (a2)
+	move.b	d2, 0x1(a2)
+	rts
+
+PlayerPsgCounters:			; C3 to B3
+	dc.w 0x0357, 0x0327, 0x02FA, 0x02CF, 0x02A7, 0x0281
+	dc.w 0x025D, 0x023B, 0x021B, 0x01FC, 0x01E0, 0x01C5
+
+PlayerFmFrequencies:			; C to B within a block
+	dc.w 653, 692, 733, 777, 823, 872
+	dc.w 924, 979, 1037, 1099, 1164, 1234
@@ -24,6 +24,7 @@ SizePalette:    equ 0x40
 hblank_counter		equ 0x00FF0000                ; Start of RAM
 vblank_counter		equ (hblank_counter+SizeLong)
 audio_clock		equ (vblank_counter+SizeLong)
+player_ram		equ (audio_clock+SizeLong)
 
 HBlankInterrupt:
    addi.l #0x1, hblank_counter    ; Increment hinterrupt counter
@@ -32,6 +33,7 @@ HBlankInterrupt:
 VBlankInterrupt:
    addi.l #0x1, vblank_counter    ; Increment vinterrupt counter
    addi.l #0x1, audio_clock       ; Increment audio clock
+   jsr PlayerUpdate               ; Advance the music by a frame
    rte ; Return from Exception
 
 Exception:
@@ -49,77 +51,31 @@ WaitVBlankEnd:
 	beq     WaitVBlankEnd   ; Branch if equal (to zero)
 	rts
 
-WaitFrames:
-	; d0 - Number of frames to wait
-	move.l  vblank_counter, d1 ; Get start vblank count
-	@Wait:
-	move.l  vblank_counter, d2 ; Get end vblank count
-	subx.l  d1, d2             ; Calc delta, result in d2
-	cmp.l   d0, d2             ; Compare with num frames
-	bge     @End               ; Branch to end if greater or equal to num frames
-	jmp     @Wait              ; Try again
-	
-	@End:
-	rts
-
-SoundTest:
-	; Bit 7   : Latch (1 = indicates this is the first (or only) byte of data)
-	; Bit 6-5 : Channel (0-3)
-	; Bit 4   : Attenuation data (1) or tone/noise data (0)
-	; Bit 3-0 : Low 4 bits of data to write to register
-	
-	; If data is more than 4 bits, send another byte...
-	; Bit 7   : Latch (0 = indicates this is the second byte of data)
-	; Bit 6   : Unused
-	; Bit 5-0 : High 6 bits of data to write to register
-	
-	move.b #%10010000, PSGCtrlPort ; Channel 0 full volume
-	
-	lea chan0_notes, a0            ; Notes to a0
-	move.l #chan0_notes_count, d1  ; Number of notes to d1
-	subi.l #0x1, d1                ; -1 for counter
-	
-	@NextNote:
-	
-	move.w (a0)+, d0       ; Delay to d0 and inc. pointer
-	move.w (a0)+, d2       ; Counter reset to d2 and inc. pointer
-	move.b d2, d3          ; Lower byte of counter reset to d3
-	and.b #%00001111, d3   ; Clear top nybble (leave lower 4 bits)
-	or.b #%10000000, d3    ; Latch bit (7) on, chan 0 (6-5), tone data bit (4) off
-	move.b d3, PSGCtrlPort ; Write to PSG port
-	
-	move.w d2, d3          ; Counter reset to d3 again
-	ror.w #0x4, d3         ; Shift right 4 bits
-	and.b #%00111111, d3   ; Only need bits 5-0 (upper 6 bits of the 10 bit value)
-	move.b d3, PSGCtrlPort ; Write to PSG port
-	
-	move.l d1, -(sp)       ; Backup d1
-	jsr WaitFrames         ; Delay frames is in d0
-	move.l (sp)+, d1       ; Restore d1
-	
-	dbra d1, @NextNote
-	
-	move.b #%10011111, PSGCtrlPort ; Silence channel 0
+	include inc/player.asm
 
-	rts
+; ************************************
+; Song: PSG tone 0-2, noise, FM 1-6
+; ************************************
+Song:
+	dc.l chan0_notes, 0, 0, 0, 0, 0, 0, 0, 0, 0
 
 chan0_notes:
-	dc.w 0x0010, 0x02f8, 0x0010, 0x02cd, 0x0010, 0x02a5, 0x0010, 0x01aa, 0x0008, 0x0000                                                 ; D3 D#3 E3 C4 .
-	dc.w 0x0010, 0x02a5, 0x0010, 0x01aa, 0x0008, 0x0000                                                                                 ; E3 C4 .
-	dc.w 0x0010, 0x02a5, 0x0010, 0x01aa, 0x0010, 0x0000                                                                                 ; E3 C4 .
-	dc.w 0x0010, 0x01aa, 0x0010, 0x0193, 0x0010, 0x017c, 0x0010, 0x0152, 0x0010, 0x01aa, 0x0010, 0x017c, 0x0010, 0x0152, 0x0008, 0x0000 ; C4 C#4 D4 E4 C4 D4 E4 .
-	dc.w 0x0010, 0x01c4, 0x0010, 0x017c, 0x0008, 0x0000                                                                                 ; B3 D4 .
-	dc.w 0x0010, 0x01aa                                                                                                                 ; C4
-	
-chan0_notes_end
-chan0_notes_len equ chan0_notes_end-chan0_notes
-chan0_notes_count equ chan0_notes_len/4
-	
+	dc.b 0xD0                                           ; Full volume
+	dc.b 0x8F, 0x32, 0x33, 0x34, 0x40, 0x87, 0xC0       ; D3 D#3 E3 C4 .
+	dc.b 0x8F, 0x34, 0x40, 0x87, 0xC0                   ; E3 C4 .
+	dc.b 0x8F, 0x34, 0x40, 0xC0                         ; E3 C4 .
+	dc.b 0x40, 0x41, 0x42, 0x44, 0x40, 0x42, 0x44, 0x87, 0xC0 ; C4 C#4 D4 E4 C4 D4 E4 .
+	dc.b 0x8F, 0x3B, 0x42, 0x87, 0xC0                   ; B3 D4 .
+	dc.b 0x8F, 0x40                                     ; C4
+	dc.b 0xFF                                           ; End
+	even
+
 __main:
 	move.w #0x8F02, VDPCtrlPort     ; Set autoincrement to 2 bytes
 	move.w #0x8708, VDPCtrlPort     ; Set background colour light blue (palette 0, colour 8)
 	
-	jsr SoundTest
+	lea Song, a0                    ; Start the song, VBlank plays it from here on
+	jsr PlayerInit
 
 	; ************************************
 	; Main game loop
@@ -33,9 +33,9 @@ const struct
     0x00100000,
     0x00FF0000,
     0x00FFFFFF,
-    "  ",
-    0x0000,
-    0x00200000,
+    "RA",
+    0xF820,
+    0x00200001,
     0x002001FF,
     "            ",
     "DEMONSTRATION PROGRAM                   ",
@@ -0,0 +1,240 @@
+#include <arpeggiator.h>
+#include <ch3voice.h>
+#include <channel.h>
+#include <genesis.h>
+#include <pitch.h>
+#include <scheduler.h>
+#include <synth.h>
+
+#define SHAPE_COUNT 6
+#define SHAPE_LENGTH 4
+
+/*
+ * While A is held the current channel steps through an interval shape on the
+ * scheduler clock. Each step is a key off, the two F-number/block writes and
+ * a key on (or just a glide when the channel is legato), leaving the rest of
+ * the patch untouched. Chord mode instead keys the shape's upper notes on the
+ * channels that are not already sounding, or on channel 3's operators when it
+ * is set up for four-voice special mode. Notes from the pad are always at
+ * full velocity. Random mode has its own xorshift
+ * generator so a replay can restore it along with the parameters.
+ */
+static const s8 SHAPES[SHAPE_COUNT][SHAPE_LENGTH] = {{0, 4, 7, 12}, {0, 3, 7, 12},
+                                                     {0, 4, 7, 11}, {0, 3, 7, 10},
+                                                     {0, 5, 7, 12}, {0, 7, 12, 19}};
+
+static void updateArpeggio(Channel *chan);
+static void step(u16 generation);
+static void playChord(void);
+static void playVoiceChord(void);
+static void stopChord(void);
+static u8 nextStep(void);
+static void playInterval(Channel *chan, s8 interval);
+static u16 nextRandom(void);
+
+static FmParameter parameters[ARP_PARAMETER_COUNT] = {
+    {ARP_OFF, ARP_CHORD, updateArpeggio}, {0, SHAPE_COUNT - 1, updateArpeggio}, {8, 31, NULL}};
+
+static Channel *arpChannel = NULL;
+static u8 chordChannels = 0;
+static bool voiceChord = false;
+static u8 stepIndex;
+static u16 generation = 0;
+static u16 randomState = 0xACE1;
+
+bool arpeggiator_isEnabled(void) { return parameters[PARAMETER_ARP_MODE].value != ARP_OFF; }
+
+void arpeggiator_start(Channel *chan)
+{
+    arpeggiator_stop();
+    arpChannel = chan;
+    channel_setVelocity(chan, FULL_VELOCITY);
+    if (parameters[PARAMETER_ARP_MODE].value == ARP_CHORD)
+    {
+        if (chan->number == CH3_VOICE_CHANNEL && ch3voice_isAvailable())
+        {
+            playVoiceChord();
+            return;
+        }
+        channel_playNote(chan);
+        playChord();
+        return;
+    }
+    channel_playNote(chan);
+    stepIndex = 0;
+    scheduler_schedule(parameters[PARAMETER_ARP_RATE].value, step, generation);
+}
+
+void arpeggiator_stop(void)
+{
+    generation++;
+    stopChord();
+    if (arpChannel != NULL)
+    {
+        channel_stopNote(arpChannel);
+        arpChannel = NULL;
+    }
+}
+
+void arpeggiator_setParameterValue(ArpParameters parameter, u16 value)
+{
+    FmParameter *p = &parameters[parameter];
+    if (value == (u16)-1)
+    {
+        value = p->maxValue;
+    }
+    if (value > p->maxValue)
+    {
+        value = 0;
+    }
+    if (parameter == PARAMETER_ARP_RATE && value == 0)
+    {
+        value = 1;
+    }
+    p->value = value;
+    if (p->onUpdate != NULL)
+    {
+        p->onUpdate(arpChannel);
+    }
+}
+
+u16 arpeggiator_parameterValue(ArpParameters parameter) { return parameters[parameter].value; }
+
+u16 arpeggiator_parameterMaxValue(ArpParameters parameter)
+{
+    return parameters[parameter].maxValue;
+}
+
+void arpeggiator_snapshot(u8 *data)
+{
+    for (u8 p = 0; p < ARP_PARAMETER_COUNT; p++)
+    {
+        data[p] = parameters[p].value;
+    }
+    data[ARP_PARAMETER_COUNT] = randomState >> 8;
+    data[ARP_PARAMETER_COUNT + 1] = randomState;
+}
+
+/* Restores the parameters without restarting anything, so stop the arpeggio first */
+void arpeggiator_restore(const u8 *data)
+{
+    for (u8 p = 0; p < ARP_PARAMETER_COUNT; p++)
+    {
+        parameters[p].value = data[p];
+    }
+    randomState = (data[ARP_PARAMETER_COUNT] << 8) | data[ARP_PARAMETER_COUNT + 1];
+}
+
+static void updateArpeggio(Channel *chan)
+{
+    if (chan == NULL)
+    {
+        return;
+    }
+    if (arpeggiator_isEnabled())
+    {
+        arpeggiator_start(chan);
+    }
+    else
+    {
+        generation++;
+        stopChord();
+    }
+}
+
+static void step(u16 stepGeneration)
+{
+    if (stepGeneration != generation || arpChannel == NULL)
+    {
+        return;
+    }
+    u8 shape = parameters[PARAMETER_ARP_SHAPE].value;
+    u8 note = channel_parameterValue(arpChannel, PARAMETER_NOTE);
+    u8 octave = channel_parameterValue(arpChannel, PARAMETER_OCTAVE);
+    pitch_transpose(&note, &octave, SHAPES[shape][nextStep()]);
+    channel_playPitch(arpChannel, note, octave);
+    scheduler_schedule(parameters[PARAMETER_ARP_RATE].value, step, generation);
+}
+
+static u8 nextStep(void)
+{
+    switch (parameters[PARAMETER_ARP_MODE].value)
+    {
+    case ARP_DOWN:
+        stepIndex = (stepIndex - 1) & (SHAPE_LENGTH - 1);
+        break;
+    case ARP_RANDOM:
+        stepIndex = nextRandom() & (SHAPE_LENGTH - 1);
+        break;
+    default:
+        stepIndex = (stepIndex + 1) & (SHAPE_LENGTH - 1);
+        break;
+    }
+    return stepIndex;
+}
+
+static void playChord(void)
+{
+    const s8 *shape = SHAPES[parameters[PARAMETER_ARP_SHAPE].value];
+    u8 interval = 1;
+    for (u8 c = 0; c < CHANNEL_COUNT && interval < SHAPE_LENGTH; c++)
+    {
+        Channel *chan = synth_channel(c);
+        if (chan == arpChannel || chan->keyedOn)
+        {
+            continue;
+        }
+        playInterval(chan, shape[interval++]);
+        channel_setVelocity(chan, FULL_VELOCITY);
+        channel_keyOn(chan);
+        chordChannels |= 1 << c;
+    }
+}
+
+static void playVoiceChord(void)
+{
+    const s8 *shape = SHAPES[parameters[PARAMETER_ARP_SHAPE].value];
+    channel_keyOff(arpChannel);
+    channel_update(arpChannel);
+    for (u8 v = 0; v < CH3_VOICE_COUNT; v++)
+    {
+        u8 note = channel_parameterValue(arpChannel, PARAMETER_NOTE);
+        u8 octave = channel_parameterValue(arpChannel, PARAMETER_OCTAVE);
+        pitch_transpose(&note, &octave, shape[v]);
+        ch3voice_noteOn(v, note, octave, FULL_VELOCITY);
+    }
+    voiceChord = true;
+}
+
+static void stopChord(void)
+{
+    if (voiceChord)
+    {
+        ch3voice_allOff();
+        voiceChord = false;
+    }
+    for (u8 c = 0; c < CHANNEL_COUNT; c++)
+    {
+        if (chordChannels & (1 << c))
+        {
+            channel_keyOff(synth_channel(c));
+        }
+    }
+    chordChannels = 0;
+}
+
+static void playInterval(Channel *chan, s8 interval)
+{
+    u8 note = channel_parameterValue(arpChannel, PARAMETER_NOTE);
+    u8 octave = channel_parameterValue(arpChannel, PARAMETER_OCTAVE);
+    pitch_transpose(&note, &octave, interval);
+    channel_setPitch(chan, note, octave);
+}
+
+static u16 nextRandom(void)
+{
+    randomState ^= randomState << 7;
+    randomState ^= randomState >> 9;
+    randomState ^= randomState << 8;
+    return randomState;
+}
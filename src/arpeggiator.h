@@ -0,0 +1,20 @@
+#pragma once
+#include <channel.h>
+#include <genesis.h>
+#include <stdbool.h>
+
+#define ARP_PARAMETER_COUNT 3
+#define ARP_SNAPSHOT_SIZE (ARP_PARAMETER_COUNT + 2)
+
+typedef enum { PARAMETER_ARP_MODE, PARAMETER_ARP_SHAPE, PARAMETER_ARP_RATE } ArpParameters;
+
+typedef enum { ARP_OFF, ARP_UP, ARP_DOWN, ARP_RANDOM, ARP_CHORD } ArpMode;
+
+bool arpeggiator_isEnabled(void);
+void arpeggiator_start(Channel *chan);
+void arpeggiator_stop(void);
+void arpeggiator_setParameterValue(ArpParameters parameter, u16 value);
+u16 arpeggiator_parameterValue(ArpParameters parameter);
+u16 arpeggiator_parameterMaxValue(ArpParameters parameter);
+void arpeggiator_snapshot(u8 *data);
+void arpeggiator_restore(const u8 *data);
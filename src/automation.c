@@ -0,0 +1,401 @@
+#include <automation.h>
+#include <genesis.h>
+#include <stdbool.h>
+
+#define HOLD_MAX_FRAMES 128
+#define CODE_DELTA 0x80
+#define CODE_ABSOLUTE 0xC0
+#define CODE_RAMP 0xE0
+#define CODE_MASK 0xE0
+#define RAMP_MAX_STEPS 32
+#define BLOCK_SIZE 32
+#define BLOCK_COUNT (AUTOMATION_POOL_SIZE / BLOCK_SIZE)
+#define DELTA_MIN -32
+#define DELTA_MAX 31
+
+/*
+ * Each parameter touched while recording gets a lane, sampled once a frame.
+ * A lane is a byte stream of:
+ *   0nnnnnnn           value held for n + 1 frames
+ *   10dddddd           value changed by the signed delta d this frame
+ *   110vvvvv vvvvvvvv  value set to v this frame
+ *   111nnnnn           the last change and the hold before it repeated
+ *                      n + 1 more times
+ * Lanes take 32-byte blocks from one 4 KB pool as they grow. A held button
+ * steps a value every 3 frames, which the ramp code stores at a byte per
+ * 32 steps; a small value that wraps around while held costs 5 bytes per
+ * cycle of 8 steps, so one lane holds over 5 minutes of either. Movement
+ * that changes every frame costs a byte a frame: 68 seconds for one lane,
+ * 8.5 seconds with all eight moving.
+ * Playback decodes at most one code per lane per frame and restarts from the
+ * recorded start values on every key on. Played values are applied without
+ * being saved or redrawn; stopping puts back the values recording ended on.
+ */
+typedef struct
+{
+    u8 chanNumber;
+    u8 selection;
+    bool full;
+    u8 hold;
+    u16 length;
+    u16 cursor;
+    u8 firstBlock;
+    u8 lastBlock;
+    u8 readBlock;
+    u16 startValue;
+    u16 endValue;
+    u16 value;
+    u16 pendingFrames;
+    s16 stepDelta;
+    bool stepValid;
+    bool rampOpen;
+    u16 stepGap;
+    u16 gap;
+    u8 rampSteps;
+    u16 rampWait;
+} Lane;
+
+static void recordFrame(void);
+static void playFrame(void);
+static void recordValue(Lane *lane, u16 value);
+static bool extendRamp(Lane *lane, s16 delta);
+static void flushHold(Lane *lane);
+static bool append(Lane *lane, u8 code, u8 size);
+static void appendByte(Lane *lane, u8 data);
+static u8 readByte(Lane *lane);
+
+static AutomationState state = AUTOMATION_IDLE;
+static AutomationRead readValue;
+static AutomationWrite writeValue;
+static Lane lanes[AUTOMATION_LANE_COUNT];
+static u8 pool[BLOCK_COUNT][BLOCK_SIZE];
+static u8 nextBlocks[BLOCK_COUNT];
+static u8 usedBlocks = 0;
+static u8 laneCount = 0;
+static u16 recordedFrames;
+
+void automation_init(AutomationRead read, AutomationWrite write)
+{
+    readValue = read;
+    writeValue = write;
+}
+
+void automation_record(void)
+{
+    laneCount = 0;
+    usedBlocks = 0;
+    recordedFrames = 0;
+    state = AUTOMATION_RECORDING;
+}
+
+void automation_play(void)
+{
+    if (state == AUTOMATION_RECORDING)
+    {
+        for (u8 l = 0; l < laneCount; l++)
+        {
+            lanes[l].endValue = readValue(lanes[l].chanNumber, lanes[l].selection);
+        }
+    }
+    state = AUTOMATION_PLAYING;
+    automation_trigger();
+}
+
+void automation_stop(void)
+{
+    if (state == AUTOMATION_PLAYING)
+    {
+        for (u8 l = 0; l < laneCount; l++)
+        {
+            writeValue(lanes[l].chanNumber, lanes[l].selection, lanes[l].endValue);
+        }
+    }
+    state = AUTOMATION_IDLE;
+}
+
+AutomationState automation_state(void) { return state; }
+
+void automation_touch(u8 chanNumber, u8 selection)
+{
+    if (state != AUTOMATION_RECORDING)
+    {
+        return;
+    }
+    for (u8 l = 0; l < laneCount; l++)
+    {
+        if (lanes[l].chanNumber == chanNumber && lanes[l].selection == selection)
+        {
+            return;
+        }
+    }
+    if (laneCount == AUTOMATION_LANE_COUNT)
+    {
+        return;
+    }
+    Lane *lane = &lanes[laneCount++];
+    lane->chanNumber = chanNumber;
+    lane->selection = selection;
+    lane->full = false;
+    lane->stepValid = false;
+    lane->length = 0;
+    lane->startValue = readValue(chanNumber, selection);
+    lane->value = lane->startValue;
+    lane->pendingFrames = recordedFrames;
+}
+
+void automation_trigger(void)
+{
+    if (state != AUTOMATION_PLAYING)
+    {
+        return;
+    }
+    for (u8 l = 0; l < laneCount; l++)
+    {
+        Lane *lane = &lanes[l];
+        lane->cursor = 0;
+        lane->readBlock = lane->firstBlock;
+        lane->hold = 0;
+        lane->gap = 0;
+        lane->rampSteps = 0;
+        lane->value = lane->startValue;
+        writeValue(lane->chanNumber, lane->selection, lane->value);
+    }
+}
+
+void automation_update(void)
+{
+    if (state == AUTOMATION_RECORDING)
+    {
+        recordFrame();
+    }
+    else if (state == AUTOMATION_PLAYING)
+    {
+        playFrame();
+    }
+}
+
+/*
+ * Writes the lanes out as a lane count followed by, for each lane, its
+ * channel, selection, big-endian start value and length, and the codes.
+ * Returns the number of bytes written, or 0 if the buffer is too small.
+ */
+u16 automation_export(u8 *buffer, u16 size)
+{
+    u16 used = 1;
+    for (u8 l = 0; l < laneCount; l++)
+    {
+        used += 6 + lanes[l].length;
+    }
+    if (used > size)
+    {
+        return 0;
+    }
+    *buffer++ = laneCount;
+    for (u8 l = 0; l < laneCount; l++)
+    {
+        Lane *lane = &lanes[l];
+        *buffer++ = lane->chanNumber;
+        *buffer++ = lane->selection;
+        *buffer++ = lane->startValue >> 8;
+        *buffer++ = lane->startValue;
+        *buffer++ = lane->length >> 8;
+        *buffer++ = lane->length;
+        u8 block = lane->firstBlock;
+        for (u16 copied = 0; copied < lane->length; copied += BLOCK_SIZE)
+        {
+            u16 count = lane->length - copied < BLOCK_SIZE ? lane->length - copied : BLOCK_SIZE;
+            memcpy(buffer, pool[block], count);
+            buffer += count;
+            block = nextBlocks[block];
+        }
+    }
+    return used;
+}
+
+static void recordFrame(void)
+{
+    for (u8 l = 0; l < laneCount; l++)
+    {
+        Lane *lane = &lanes[l];
+        u16 value = readValue(lane->chanNumber, lane->selection);
+        if (value == lane->value)
+        {
+            lane->pendingFrames++;
+        }
+        else
+        {
+            recordValue(lane, value);
+        }
+    }
+    recordedFrames++;
+}
+
+static void recordValue(Lane *lane, u16 value)
+{
+    s16 delta = value - lane->value;
+    if (extendRamp(lane, delta))
+    {
+        lane->pendingFrames = 0;
+        lane->value = value;
+        return;
+    }
+    u16 gap = lane->pendingFrames;
+    flushHold(lane);
+    bool stored;
+    if (delta >= DELTA_MIN && delta <= DELTA_MAX)
+    {
+        stored = append(lane, CODE_DELTA | (delta & 0x3F), 1);
+    }
+    else
+    {
+        stored = append(lane, CODE_ABSOLUTE | (value >> 8), 2);
+        if (stored)
+        {
+            appendByte(lane, value);
+        }
+    }
+    lane->stepValid = stored;
+    lane->rampOpen = false;
+    if (stored)
+    {
+        lane->stepDelta = delta;
+        lane->stepGap = gap;
+        lane->value = value;
+    }
+}
+
+/*
+ * Counts a change into a ramp code when it repeats the last delta after the
+ * same number of held frames, opening a new code once one is full.
+ */
+static bool extendRamp(Lane *lane, s16 delta)
+{
+    if (!lane->stepValid || delta != lane->stepDelta || lane->pendingFrames != lane->stepGap)
+    {
+        return false;
+    }
+    u8 *last = &pool[lane->lastBlock][(lane->length - 1) % BLOCK_SIZE];
+    if (lane->rampOpen && (*last & ~CODE_MASK) < RAMP_MAX_STEPS - 1)
+    {
+        (*last)++;
+        return true;
+    }
+    lane->rampOpen = append(lane, CODE_RAMP, 1);
+    return lane->rampOpen;
+}
+
+static void flushHold(Lane *lane)
+{
+    while (lane->pendingFrames > 0)
+    {
+        u16 frames = lane->pendingFrames;
+        if (frames > HOLD_MAX_FRAMES)
+        {
+            frames = HOLD_MAX_FRAMES;
+        }
+        if (!append(lane, frames - 1, 1))
+        {
+            return;
+        }
+        lane->pendingFrames -= frames;
+    }
+}
+
+/* Appends a code of size bytes, the first of them given, if the pool has room */
+static bool append(Lane *lane, u8 code, u8 size)
+{
+    u16 room = (BLOCK_COUNT - usedBlocks) * BLOCK_SIZE;
+    if (lane->length % BLOCK_SIZE != 0)
+    {
+        room += BLOCK_SIZE - lane->length % BLOCK_SIZE;
+    }
+    if (lane->full || size > room)
+    {
+        lane->full = true;
+        return false;
+    }
+    appendByte(lane, code);
+    return true;
+}
+
+static void appendByte(Lane *lane, u8 data)
+{
+    if (lane->length % BLOCK_SIZE == 0)
+    {
+        u8 block = usedBlocks++;
+        if (lane->length == 0)
+        {
+            lane->firstBlock = block;
+        }
+        else
+        {
+            nextBlocks[lane->lastBlock] = block;
+        }
+        lane->lastBlock = block;
+    }
+    pool[lane->lastBlock][lane->length++ % BLOCK_SIZE] = data;
+}
+
+static u8 readByte(Lane *lane)
+{
+    if (lane->cursor % BLOCK_SIZE == 0 && lane->cursor != 0)
+    {
+        lane->readBlock = nextBlocks[lane->readBlock];
+    }
+    return pool[lane->readBlock][lane->cursor++ % BLOCK_SIZE];
+}
+
+static void playFrame(void)
+{
+    for (u8 l = 0; l < laneCount; l++)
+    {
+        Lane *lane = &lanes[l];
+        if (lane->hold > 0)
+        {
+            lane->hold--;
+            continue;
+        }
+        if (lane->rampSteps == 0)
+        {
+            if (lane->cursor >= lane->length)
+            {
+                continue;
+            }
+            u8 code = readByte(lane);
+            if (!(code & CODE_DELTA))
+            {
+                lane->hold = code;
+                lane->gap += code + 1;
+                continue;
+            }
+            if ((code & CODE_MASK) == CODE_RAMP)
+            {
+                lane->rampSteps = (code & ~CODE_MASK) + 1;
+                lane->rampWait = lane->stepGap;
+            }
+            else
+            {
+                u16 value = lane->value + ((s8)(code << 2) >> 2);
+                if ((code & CODE_MASK) == CODE_ABSOLUTE)
+                {
+                    value = ((code & 0x1F) << 8) | readByte(lane);
+                }
+                lane->stepDelta = value - lane->value;
+                lane->stepGap = lane->gap;
+                lane->gap = 0;
+                lane->value = value;
+                writeValue(lane->chanNumber, lane->selection, lane->value);
+                continue;
+            }
+        }
+        if (lane->rampWait > 0)
+        {
+            lane->rampWait--;
+            continue;
+        }
+        lane->rampSteps--;
+        lane->rampWait = lane->stepGap;
+        lane->value += lane->stepDelta;
+        writeValue(lane->chanNumber, lane->selection, lane->value);
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <genesis.h>
+
+#define AUTOMATION_LANE_COUNT 8
+#define AUTOMATION_POOL_SIZE 4096
+
+typedef enum { AUTOMATION_IDLE, AUTOMATION_RECORDING, AUTOMATION_PLAYING } AutomationState;
+
+typedef u16 (*AutomationRead)(u8 chanNumber, u8 selection);
+typedef void (*AutomationWrite)(u8 chanNumber, u8 selection, u16 value);
+
+void automation_init(AutomationRead read, AutomationWrite write);
+void automation_record(void);
+void automation_play(void);
+void automation_stop(void);
+AutomationState automation_state(void);
+void automation_touch(u8 chanNumber, u8 selection);
+void automation_trigger(void);
+void automation_update(void);
+u16 automation_export(u8 *buffer, u16 size);
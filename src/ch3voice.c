@@ -0,0 +1,88 @@
+#include <ch3voice.h>
+#include <channel.h>
+#include <envelope.h>
+#include <genesis.h>
+#include <megadrive.h>
+#include <pitch.h>
+#include <synth.h>
+
+#define ALL_CARRIERS_ALGORITHM 7
+
+/*
+ * With channel 3 in special mode each operator has its own F-number/block
+ * register, so under algorithm 7 (all carriers) the four operators can be
+ * played as independent voices. A note is two frequency writes, the level
+ * of its operator for the note's velocity, and a key on/off write carrying
+ * only the slots of the voices that are sounding.
+ * Slot bits in register 0x28 are ordered S1, S2, S3, S4 while operators are
+ * numbered in register order (S1, S3, S2, S4).
+ */
+static const u8 SLOT_KEY_BITS[CH3_VOICE_COUNT] = {0x10, 0x40, 0x20, 0x80};
+
+static void writeKeys(void);
+
+static u8 keyedSlots = 0;
+static u8 voiceAge[CH3_VOICE_COUNT];
+static u8 noteCounter = 0;
+
+bool ch3voice_isAvailable(void)
+{
+    return channel_parameterValue(synth_channel(CH3_VOICE_CHANNEL), PARAMETER_ALGORITHM)
+        == ALL_CARRIERS_ALGORITHM;
+}
+
+u8 ch3voice_allocate(void)
+{
+    u8 oldest = 0;
+    for (u8 v = 0; v < CH3_VOICE_COUNT; v++)
+    {
+        if (!(keyedSlots & SLOT_KEY_BITS[v]))
+        {
+            return v;
+        }
+        if ((u8)(noteCounter - voiceAge[v]) > (u8)(noteCounter - voiceAge[oldest]))
+        {
+            oldest = v;
+        }
+    }
+    return oldest;
+}
+
+void ch3voice_noteOn(u8 voice, u8 note, u8 octave, u8 velocity)
+{
+    Channel *chan = synth_channel(CH3_VOICE_CHANNEL);
+    keyedSlots &= ~SLOT_KEY_BITS[voice];
+    writeKeys();
+    channel_setOperatorVelocity(chan, voice, velocity);
+    operator_setFrequency(channel_operator(chan, voice), octave, pitch_noteFrequency(note));
+    keyedSlots |= SLOT_KEY_BITS[voice];
+    voiceAge[voice] = noteCounter++;
+    writeKeys();
+}
+
+void ch3voice_noteOff(u8 voice)
+{
+    keyedSlots &= ~SLOT_KEY_BITS[voice];
+    writeKeys();
+}
+
+void ch3voice_allOff(void)
+{
+    keyedSlots = 0;
+    writeKeys();
+}
+
+static void writeKeys(void)
+{
+    megadrive_writeToYm2612Part(0, 0x28, keyedSlots | CH3_VOICE_CHANNEL);
+    synth_channel(CH3_VOICE_CHANNEL)->keyedOn = keyedSlots != 0;
+    u8 keyedVoices = 0;
+    for (u8 v = 0; v < CH3_VOICE_COUNT; v++)
+    {
+        if (keyedSlots & SLOT_KEY_BITS[v])
+        {
+            keyedVoices |= 1 << v;
+        }
+    }
+    envelope_key(CH3_VOICE_CHANNEL, keyedVoices);
+}
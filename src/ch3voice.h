@@ -0,0 +1,12 @@
+#pragma once
+#include <genesis.h>
+#include <stdbool.h>
+
+#define CH3_VOICE_CHANNEL 2
+#define CH3_VOICE_COUNT 4
+
+bool ch3voice_isAvailable(void);
+u8 ch3voice_allocate(void);
+void ch3voice_noteOn(u8 voice, u8 note, u8 octave, u8 velocity);
+void ch3voice_noteOff(u8 voice);
+void ch3voice_allOff(void);
@@ -1,19 +1,55 @@
 #include <channel.h>
+#include <envelope.h>
 #include <megadrive.h>
+#include <pitch.h>
+
+#define GLIDE_FRACTION_BITS 4
+#define GLIDE_UNITS_PER_OCTAVE (PITCH_STEPS_PER_OCTAVE << GLIDE_FRACTION_BITS)
+#define GLIDE_RATE_COUNT 32
 
 static void updateAlgorithmAndFeedback(Channel *chan);
 static void updateStereoAndLFO(Channel *chan);
 static void updateFreqAndOctave(Channel *chan);
 static void updateNote(Channel *chan);
 static void setFrequency(Channel *chan, u16 freq, u8 octave);
+static void glideTo(Channel *chan, u16 freq, u8 octave);
+static void jumpTo(Channel *chan, u16 freq, u8 octave);
 static void setAlgorithm(Channel *chan, u8 algorithm, u8 feedback);
 static void setStereoAndLFO(Channel *chan, u8 stereo, u8 ams, u8 fms);
-static void keyOn(Channel *chan);
-static void keyOff(Channel *chan);
+static void applyVelocities(Channel *chan);
 static u8 keyRegValue(Channel *chan);
 
 static const u16 defaultOperatorValues[OPERATOR_COUNT][OPERATOR_PARAMETER_COUNT];
 
+/*
+ * Carrier operators for each algorithm, as bits in register order (S1, S3,
+ * S2, S4), and the attenuation added to their total level for each MIDI
+ * velocity: 40 log10(velocity / 127) dB in 0.75 dB steps.
+ */
+static const u8 CARRIER_MASKS[8] = {0x08, 0x08, 0x08, 0x08, 0x0C, 0x0E, 0x0E, 0x0F};
+
+static const u8 VELOCITY_ATTENUATION[FULL_VELOCITY + 1] = {
+    127, 112, 96, 87, 80, 75, 71, 67, 64, 61, 59, 57, 55, 53, 51, 49,
+    48, 47, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33, 33,
+    32, 31, 31, 30, 29, 29, 28, 27, 27, 26, 26, 25, 25, 24, 24, 23,
+    23, 22, 22, 21, 21, 20, 20, 19, 19, 19, 18, 18, 17, 17, 17, 16,
+    16, 16, 15, 15, 14, 14, 14, 13, 13, 13, 13, 12, 12, 12, 11, 11,
+    11, 10, 10, 10, 10, 9, 9, 9, 8, 8, 8, 8, 7, 7, 7, 7,
+    6, 6, 6, 6, 6, 5, 5, 5, 5, 4, 4, 4, 4, 4, 3, 3,
+    3, 3, 3, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 0, 0, 0};
+
+/*
+ * Glides move through a linear pitch domain of 1/256 semitone units within a
+ * block, looked up in the fine F-number table. Each frame adds the rate and
+ * carries into the block at most once, then writes the two frequency
+ * registers. The last step writes the exact target F-number. Rates are in
+ * units per frame, from 12 semitones down to 1/128 semitone; 0 turns gliding off.
+ */
+static const s16 GLIDE_RATES[GLIDE_RATE_COUNT] = {0,   3072, 2396, 1869, 1458, 1137, 887, 692,
+                                                  540, 421,  328,  256,  200,  156,  122, 95,
+                                                  74,  58,   45,   35,   27,   21,   17,  13,
+                                                  10,  8,    6,    5,    4,    3,    2,   2};
+
 FmParameter *channel_fmParameter(Channel *chan, FmParameters parameter)
 {
     return &chan->fmParameters[parameter];
@@ -24,6 +60,7 @@ Operator *channel_operator(Channel *chan, u8 opNumber) { return &chan->operators
 void channel_init(Channel *chan, u8 number)
 {
     chan->number = number;
+    chan->keyedOn = false;
     FmParameter fmParas[] = {{1, 11, updateNote},
                              {653, 2047, updateFreqAndOctave},
                              {4, 7, updateFreqAndOctave},
@@ -31,11 +68,14 @@ void channel_init(Channel *chan, u8 number)
                              {0, 7, updateAlgorithmAndFeedback},
                              {0, 3, updateStereoAndLFO},
                              {0, 7, updateStereoAndLFO},
-                             {3, 3, updateStereoAndLFO}};
+                             {3, 3, updateStereoAndLFO},
+                             {0, GLIDE_RATE_COUNT - 1, NULL},
+                             {0, 1, NULL}};
     memcpy(&chan->fmParameters[0], &fmParas, sizeof(FmParameter) * FM_PARAMETER_COUNT);
     for (u8 i = 0; i < OPERATOR_COUNT; i++)
     {
         operator_init(&chan->operators[i], i, chan->number, &defaultOperatorValues[i][0]);
+        chan->velocities[i] = FULL_VELOCITY;
     }
 }
 
@@ -52,12 +92,91 @@ void channel_update(Channel *chan)
 
 void channel_playNote(Channel *chan)
 {
-    keyOff(chan);
+    if (chan->keyedOn && chan->fmParameters[PARAMETER_LEGATO].value)
+    {
+        channel_update(chan);
+        return;
+    }
+    channel_keyOff(chan);
     channel_update(chan);
-    keyOn(chan);
+    channel_keyOn(chan);
+}
+
+void channel_stopNote(Channel *chan) { channel_keyOff(chan); }
+
+void channel_setPitch(Channel *chan, u8 note, u8 octave)
+{
+    glideTo(chan, pitch_noteFrequency(note), octave);
+}
+
+void channel_setFrequency(Channel *chan, u16 freq, u8 octave) { jumpTo(chan, freq, octave); }
+
+void channel_playPitch(Channel *chan, u8 note, u8 octave)
+{
+    channel_playFrequency(chan, pitch_noteFrequency(note), octave);
 }
 
-void channel_stopNote(Channel *chan) { keyOff(chan); }
+/* Glides to a new note, keying it on again unless legato and already sounding */
+void channel_playFrequency(Channel *chan, u16 freq, u8 octave)
+{
+    if (chan->keyedOn && chan->fmParameters[PARAMETER_LEGATO].value)
+    {
+        glideTo(chan, freq, octave);
+        return;
+    }
+    channel_keyOff(chan);
+    glideTo(chan, freq, octave);
+    channel_keyOn(chan);
+}
+
+/*
+ * Scales the carriers' levels for the next note on. Only TL registers whose
+ * level changes are written, so a full velocity note on a channel already at
+ * full velocity writes nothing. The key on writes out the queued levels.
+ */
+void channel_setVelocity(Channel *chan, u8 velocity)
+{
+    for (u8 o = 0; o < OPERATOR_COUNT; o++)
+    {
+        chan->velocities[o] = velocity;
+    }
+    applyVelocities(chan);
+}
+
+/* For channel 3 voices, where each operator is a note of its own */
+void channel_setOperatorVelocity(Channel *chan, u8 opNumber, u8 velocity)
+{
+    chan->velocities[opNumber] = velocity;
+    applyVelocities(chan);
+}
+
+void channel_updateGlide(Channel *chan)
+{
+    Glide *glide = &chan->glide;
+    if (glide->remaining == 0)
+    {
+        return;
+    }
+    if (glide->rate > 0 ? glide->rate >= glide->remaining : glide->rate <= glide->remaining)
+    {
+        jumpTo(chan, glide->targetFreq, glide->targetOctave);
+        return;
+    }
+    glide->remaining -= glide->rate;
+    s16 position = glide->position + glide->rate;
+    if (position >= GLIDE_UNITS_PER_OCTAVE)
+    {
+        position -= GLIDE_UNITS_PER_OCTAVE;
+        glide->octave++;
+    }
+    else if (position < 0)
+    {
+        position += GLIDE_UNITS_PER_OCTAVE;
+        glide->octave--;
+    }
+    glide->position = position;
+    setFrequency(chan, pitch_fineFrequency(position >> GLIDE_FRACTION_BITS), glide->octave);
+}
 
 void channel_setParameterValue(Channel *chan, FmParameters parameter, u16 value)
 {
@@ -71,7 +190,10 @@ void channel_setParameterValue(Channel *chan, FmParameters parameter, u16 value)
         value = 0;
     }
     fmParameter->value = value;
-    fmParameter->onUpdate(chan);
+    if (fmParameter->onUpdate != NULL)
+    {
+        fmParameter->onUpdate(chan);
+    }
 }
 
 u16 channel_parameterValue(Channel *chan, FmParameters parameter)
@@ -79,15 +201,25 @@ u16 channel_parameterValue(Channel *chan, FmParameters parameter)
     return chan->fmParameters[parameter].value;
 }
 
-static void keyOn(Channel *chan)
+u16 channel_parameterMaxValue(Channel *chan, FmParameters parameter)
+{
+    return chan->fmParameters[parameter].maxValue;
+}
+
+void channel_keyOn(Channel *chan)
 {
     u8 chanRegValue = keyRegValue(chan);
-    YM2612_writeReg(0, 0x28, 0xF0 | chanRegValue);
+    megadrive_writeToYm2612Part(0, 0x28, 0xF0 | chanRegValue);
+    chan->keyedOn = true;
+    envelope_key(chan->number, ALL_OPERATORS);
 }
-static void keyOff(Channel *chan)
+
+void channel_keyOff(Channel *chan)
 {
     u8 chanRegValue = keyRegValue(chan);
-    YM2612_writeReg(0, 0x28, 0x00 | chanRegValue);
+    megadrive_writeToYm2612Part(0, 0x28, 0x00 | chanRegValue);
+    chan->keyedOn = false;
+    envelope_key(chan->number, 0);
 }
 
 static u8 keyRegValue(Channel *chan)
@@ -107,6 +239,33 @@ static void setFrequency(Channel *chan, u16 freq, u8 octave)
     megadrive_writeToYm2612(chan->number, 0xA0, freq);
 }
 
+static void glideTo(Channel *chan, u16 freq, u8 octave)
+{
+    Glide *glide = &chan->glide;
+    s16 rate = GLIDE_RATES[chan->fmParameters[PARAMETER_GLIDE].value];
+    if (rate == 0)
+    {
+        jumpTo(chan, freq, octave);
+        return;
+    }
+    u8 targetOctave = octave;
+    s16 target = pitch_fineStep(freq, &targetOctave) << GLIDE_FRACTION_BITS;
+    glide->remaining = (targetOctave - glide->octave) * GLIDE_UNITS_PER_OCTAVE + target
+        - glide->position;
+    glide->rate = glide->remaining < 0 ? -rate : rate;
+    glide->targetFreq = freq;
+    glide->targetOctave = octave;
+}
+
+static void jumpTo(Channel *chan, u16 freq, u8 octave)
+{
+    Glide *glide = &chan->glide;
+    glide->remaining = 0;
+    glide->octave = octave;
+    glide->position = pitch_fineStep(freq, &glide->octave) << GLIDE_FRACTION_BITS;
+    setFrequency(chan, freq, octave);
+}
+
 static void setAlgorithm(Channel *chan, u8 algorithm, u8 feedback)
 {
     megadrive_writeToYm2612(chan->number, 0xB0, algorithm | (feedback << 3));
@@ -114,9 +273,8 @@ static void setAlgorithm(Channel *chan, u8 algorithm, u8 feedback)
 
 static void updateNote(Channel *chan)
 {
-    const u16 notes_freq[] = {617, 653, 692, 733, 777, 823, 872, 924, 979, 1037, 1099, 1164};
     u16 note_index = chan->fmParameters[PARAMETER_NOTE].value;
-    u16 note_freq = notes_freq[note_index];
+    u16 note_freq = pitch_noteFrequency(note_index);
     chan->fmParameters[PARAMETER_FREQ].value = note_freq;
     chan->fmParameters[PARAMETER_FREQ].onUpdate(chan);
 }
@@ -130,7 +288,7 @@ static void updateStereoAndLFO(Channel *chan)
 
 static void updateFreqAndOctave(Channel *chan)
 {
-    setFrequency(chan, chan->fmParameters[PARAMETER_FREQ].value,
+    glideTo(chan, chan->fmParameters[PARAMETER_FREQ].value,
                  chan->fmParameters[PARAMETER_OCTAVE].value);
 }
 
@@ -138,4 +296,17 @@ static void updateAlgorithmAndFeedback(Channel *chan)
 {
     setAlgorithm(chan, chan->fmParameters[PARAMETER_ALGORITHM].value,
                  chan->fmParameters[PARAMETER_FEEDBACK].value);
+    applyVelocities(chan);
+}
+
+/* Attenuates the carriers of the current algorithm and only those */
+static void applyVelocities(Channel *chan)
+{
+    u8 carriers = CARRIER_MASKS[chan->fmParameters[PARAMETER_ALGORITHM].value];
+    for (u8 o = 0; o < OPERATOR_COUNT; o++)
+    {
+        operator_setAttenuation(&chan->operators[o], (carriers & (1 << o))
+                                    ? VELOCITY_ATTENUATION[chan->velocities[o]]
+                                    : 0);
+    }
 }
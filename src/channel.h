@@ -1,9 +1,11 @@
 #pragma once
 #include <genesis.h>
 #include <operator.h>
+#include <stdbool.h>
 
 #define OPERATOR_COUNT 4
-#define FM_PARAMETER_COUNT 8
+#define FM_PARAMETER_COUNT 10
+#define FULL_VELOCITY 127
 
 typedef struct Channel Channel;
 typedef struct FmParameter FmParameter;
@@ -15,9 +17,22 @@ struct FmParameter
     void (*onUpdate)(Channel *chan);
 };
 
+typedef struct
+{
+    u16 position;
+    u8 octave;
+    s16 rate;
+    s16 remaining;
+    u16 targetFreq;
+    u8 targetOctave;
+} Glide;
+
 struct Channel
 {
     u8 number;
+    bool keyedOn;
+    u8 velocities[OPERATOR_COUNT];
+    Glide glide;
     Operator operators[OPERATOR_COUNT];
     FmParameter fmParameters[FM_PARAMETER_COUNT];
 };
@@ -30,7 +45,9 @@ typedef enum {
     PARAMETER_FEEDBACK,
     PARAMETER_LFO_AMS,
     PARAMETER_LFO_FMS,
-    PARAMETER_STEREO
+    PARAMETER_STEREO,
+    PARAMETER_GLIDE,
+    PARAMETER_LEGATO
 } FmParameters;
 
 void channel_init(Channel *chan, u8 number);
@@ -38,5 +55,15 @@ void channel_update(Channel *chan);
 Operator *channel_operator(Channel *chan, u8 opNumber);
 void channel_playNote(Channel *chan);
 void channel_stopNote(Channel *chan);
+void channel_keyOn(Channel *chan);
+void channel_keyOff(Channel *chan);
+void channel_setPitch(Channel *chan, u8 note, u8 octave);
+void channel_setFrequency(Channel *chan, u16 freq, u8 octave);
+void channel_playPitch(Channel *chan, u8 note, u8 octave);
+void channel_playFrequency(Channel *chan, u16 freq, u8 octave);
+void channel_setVelocity(Channel *chan, u8 velocity);
+void channel_setOperatorVelocity(Channel *chan, u8 opNumber, u8 velocity);
+void channel_updateGlide(Channel *chan);
 void channel_setParameterValue(Channel *chan, FmParameters parameter, u16 value);
 u16 channel_parameterValue(Channel *chan, FmParameters parameter);
+u16 channel_parameterMaxValue(Channel *chan, FmParameters parameter);
@@ -0,0 +1,223 @@
+#include <channel.h>
+#include <envelope.h>
+#include <genesis.h>
+#include <profiler.h>
+#include <synth.h>
+
+#define FRACTION_BITS 6
+#define LEVEL_MAX (ENVELOPE_SILENT << FRACTION_BITS)
+#define ATTACK_UNIT (1 << (4 + FRACTION_BITS))
+#define NO_SHIFT 16
+#define SUSTAIN_MAX 15
+#define SUSTAIN_MAX_LEVEL 0x3E0
+#define OPERATORS_PER_FRAME 12
+#define FRAMES_PER_PASS (CHANNEL_COUNT * OPERATOR_COUNT / OPERATORS_PER_FRAME)
+#define RATE_COUNT 64
+
+typedef enum { PHASE_OFF, PHASE_ATTACK, PHASE_DECAY1, PHASE_DECAY2, PHASE_RELEASE } Phase;
+
+/*
+ * A software model of each operator's envelope generator, for display only.
+ * Levels are attenuations with 6 fraction bits. Key scaling is ignored.
+ * envelope_update advances 12 of the 24 operators each frame, round-robin,
+ * so each one moves by two frames' worth of its rate every other frame and
+ * the cost per frame is fixed: 12 advances of one add or two shifts, and at
+ * most 12 phase entries of a few parameter reads. Decay and release add the
+ * step of their rate. Attack subtracts level / 2^a + level / 2^b, the shifts
+ * chosen from the step, which follows the chip's exponential curve to within
+ * a quarter of the rate.
+ */
+typedef struct
+{
+    Phase phase;
+    u16 level;
+    u16 step;
+    u16 sustain;
+    u8 attackShift;
+    u8 attackShift2;
+} Envelope;
+
+/* Attenuation added per NTSC frame (~296 envelope clocks) for each effective rate */
+static const u16 RATE_STEPS[RATE_COUNT] = {
+    0,     0,     14,    16,    18,    23,    28,    32,    37,    46,    56,    65,    74,
+    92,    111,   130,   148,   185,   222,   259,   296,   370,   444,   518,   592,   740,
+    888,   1036,  1184,  1480,  1776,  2072,  2368,  2960,  3552,  4144,  4736,  5920,  7104,
+    8288,  9472,  11840, 14208, 16576, 18944, 23680, 28416, 33152, 37888, 47360, 56832, LEVEL_MAX,
+    LEVEL_MAX, LEVEL_MAX, LEVEL_MAX, LEVEL_MAX, LEVEL_MAX, LEVEL_MAX, LEVEL_MAX, LEVEL_MAX,
+    LEVEL_MAX, LEVEL_MAX, LEVEL_MAX, LEVEL_MAX};
+
+static void enterPhase(u8 chanNumber, u8 opNumber, Phase phase);
+static void advance(u8 chanNumber, u8 opNumber);
+static void setAttackShifts(Envelope *env);
+
+static Envelope envelopes[CHANNEL_COUNT][OPERATOR_COUNT];
+static u8 keyed[CHANNEL_COUNT];
+static u16 passSteps[RATE_COUNT];
+static u8 nextOperator = 0;
+
+void envelope_init(void)
+{
+    for (u8 rate = 0; rate < RATE_COUNT; rate++)
+    {
+        u32 step = RATE_STEPS[rate];
+        if (SYS_isPAL())
+        {
+            step += step / 5;
+        }
+        step *= FRAMES_PER_PASS;
+        passSteps[rate] = step > LEVEL_MAX ? LEVEL_MAX : step;
+    }
+    for (u8 chanNumber = 0; chanNumber < CHANNEL_COUNT; chanNumber++)
+    {
+        keyed[chanNumber] = 0;
+        for (u8 opNumber = 0; opNumber < OPERATOR_COUNT; opNumber++)
+        {
+            Envelope *env = &envelopes[chanNumber][opNumber];
+            env->phase = PHASE_OFF;
+            env->level = LEVEL_MAX;
+        }
+    }
+}
+
+/*
+ * Main loop only, like envelope_update: scheduler events and MIDI notes are
+ * dispatched from there too, so the model needs no interrupt locking.
+ */
+void envelope_key(u8 chanNumber, u8 opMask)
+{
+    u8 changed = keyed[chanNumber] ^ opMask;
+    keyed[chanNumber] = opMask;
+    for (u8 opNumber = 0; opNumber < OPERATOR_COUNT; opNumber++)
+    {
+        if (changed & (1 << opNumber))
+        {
+            enterPhase(chanNumber, opNumber,
+                       (opMask & (1 << opNumber)) ? PHASE_ATTACK : PHASE_RELEASE);
+        }
+    }
+}
+
+void envelope_update(void)
+{
+    profiler_begin(PROFILER_ENVELOPE);
+    for (u8 i = 0; i < OPERATORS_PER_FRAME; i++)
+    {
+        advance(nextOperator / OPERATOR_COUNT, nextOperator % OPERATOR_COUNT);
+        if (++nextOperator == CHANNEL_COUNT * OPERATOR_COUNT)
+        {
+            nextOperator = 0;
+        }
+    }
+    profiler_end(PROFILER_ENVELOPE);
+}
+
+u16 envelope_level(u8 chanNumber, u8 opNumber)
+{
+    Operator *op = channel_operator(synth_channel(chanNumber), opNumber);
+    u16 level = (envelopes[chanNumber][opNumber].level >> FRACTION_BITS)
+        + (operator_parameterValue(op, OP_PARAMETER_TL) << 3);
+    return level > ENVELOPE_SILENT ? ENVELOPE_SILENT : level;
+}
+
+static void enterPhase(u8 chanNumber, u8 opNumber, Phase phase)
+{
+    Envelope *env = &envelopes[chanNumber][opNumber];
+    Operator *op = channel_operator(synth_channel(chanNumber), opNumber);
+    env->phase = phase;
+    switch (phase)
+    {
+    case PHASE_ATTACK:
+    {
+        u16 sustain = operator_parameterValue(op, OP_PARAMETER_D1L);
+        env->sustain = (sustain == SUSTAIN_MAX ? SUSTAIN_MAX_LEVEL : sustain << 5)
+            << FRACTION_BITS;
+        env->step = passSteps[operator_parameterValue(op, OP_PARAMETER_AR) << 1];
+        if (env->step >= ATTACK_UNIT)
+        {
+            env->level = 0;
+            enterPhase(chanNumber, opNumber, PHASE_DECAY1);
+        }
+        else
+        {
+            setAttackShifts(env);
+        }
+        break;
+    }
+    case PHASE_DECAY1:
+        env->step = passSteps[operator_parameterValue(op, OP_PARAMETER_D1R) << 1];
+        break;
+    case PHASE_DECAY2:
+        env->step = passSteps[operator_parameterValue(op, OP_PARAMETER_D2R) << 1];
+        break;
+    case PHASE_RELEASE:
+        env->step = passSteps[(operator_parameterValue(op, OP_PARAMETER_RR) << 2) + 2];
+        break;
+    default:
+        env->step = 0;
+        break;
+    }
+}
+
+static void advance(u8 chanNumber, u8 opNumber)
+{
+    Envelope *env = &envelopes[chanNumber][opNumber];
+    switch (env->phase)
+    {
+    case PHASE_ATTACK:
+        if (env->step != 0)
+        {
+            u16 delta = (env->level >> env->attackShift) + (env->level >> env->attackShift2) + 1;
+            env->level = delta >= env->level ? 0 : env->level - delta;
+            if (env->level == 0)
+            {
+                enterPhase(chanNumber, opNumber, PHASE_DECAY1);
+            }
+        }
+        break;
+    case PHASE_DECAY1:
+        if ((u32)env->level + env->step >= env->sustain)
+        {
+            env->level = env->sustain;
+            enterPhase(chanNumber, opNumber, PHASE_DECAY2);
+        }
+        else
+        {
+            env->level += env->step;
+        }
+        break;
+    case PHASE_DECAY2:
+    case PHASE_RELEASE:
+        if ((u32)env->level + env->step >= LEVEL_MAX)
+        {
+            env->level = LEVEL_MAX;
+            if (env->phase == PHASE_RELEASE)
+            {
+                enterPhase(chanNumber, opNumber, PHASE_OFF);
+            }
+        }
+        else
+        {
+            env->level += env->step;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ * Splits an attack step below ATTACK_UNIT into 2^-s times 1, 1.25, 1.5 or
+ * 1.75, the last rounded up to 2, as the fraction of the level taken off
+ * per pass.
+ */
+static void setAttackShifts(Envelope *env)
+{
+    u8 shift = 0;
+    while (env->step != 0 && (u32)env->step << shift < ATTACK_UNIT)
+    {
+        shift++;
+    }
+    u8 quarter = (((u32)env->step << shift) / (ATTACK_UNIT / 4)) & 3;
+    env->attackShift = quarter == 3 ? shift - 1 : shift;
+    env->attackShift2 = quarter == 1 ? shift + 2 : quarter == 2 ? shift + 1 : NO_SHIFT;
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <genesis.h>
+
+#define ENVELOPE_SILENT 0x3FF
+#define ALL_OPERATORS 0x0F
+
+void envelope_init(void);
+void envelope_key(u8 chanNumber, u8 opMask);
+void envelope_update(void);
+u16 envelope_level(u8 chanNumber, u8 opNumber);
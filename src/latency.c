@@ -0,0 +1,96 @@
+#include <genesis.h>
+#include <latency.h>
+#include <profiler.h>
+
+#define KEY_REGISTER 0x28
+#define KEY_SLOTS 0xF0
+#define KEY_CHANNEL_CODE 0x07
+#define PART_CHANNELS 3
+#define LATENCY_TIMEOUT_FRAMES 8
+
+/*
+ * Measures the time from a play button edge, seen in the VBlank interrupt,
+ * to the next key on of the channel the button plays, in the profiler's
+ * timestamps. The edge counts from the start of the VBlank it was seen in. An edge that keys nothing, such as a press while the
+ * channel is muted, is dropped after LATENCY_TIMEOUT_FRAMES so it neither
+ * blocks later edges nor matches an unrelated key on. Replayed input goes
+ * through the same edge detection, so a replay is measured like live play.
+ */
+static void addSample(u16 lines);
+static bool expired(u32 now);
+
+static volatile bool pending = false;
+static u32 inputTime;
+static u8 inputChannelCode;
+static LatencyStats stats;
+static bool newSample = false;
+
+void latency_markInput(u8 chanNumber)
+{
+    u32 now = profiler_vblankTime();
+    if (!pending || expired(now))
+    {
+        inputTime = now;
+        inputChannelCode = chanNumber < PART_CHANNELS ? chanNumber : chanNumber + 1;
+        pending = true;
+    }
+}
+
+void latency_traceWrite(u8 part, u8 reg, u8 data)
+{
+    if (!pending || part != 0 || reg != KEY_REGISTER || !(data & KEY_SLOTS)
+        || (data & KEY_CHANNEL_CODE) != inputChannelCode)
+    {
+        return;
+    }
+    pending = false;
+    u32 now = profiler_timestamp();
+    if (!expired(now))
+    {
+        u32 lines = (now - inputTime) >> PROFILER_LINE_SHIFT;
+        addSample(lines > 0xFFFF ? 0xFFFF : lines);
+    }
+}
+
+void latency_reset(void)
+{
+    memset(&stats, 0, sizeof(stats));
+    pending = false;
+    newSample = true;
+}
+
+bool latency_hasNewSample(void)
+{
+    bool result = newSample;
+    newSample = false;
+    return result;
+}
+
+const LatencyStats *latency_stats(void) { return &stats; }
+
+static bool expired(u32 now)
+{
+    return now - inputTime
+           > (u32)(LATENCY_TIMEOUT_FRAMES * profiler_frameLines()) << PROFILER_LINE_SHIFT;
+}
+
+static void addSample(u16 lines)
+{
+    if (stats.count == 0xFFFF)
+    {
+        return;
+    }
+    if (stats.count == 0 || lines < stats.min)
+    {
+        stats.min = lines;
+    }
+    if (lines > stats.max)
+    {
+        stats.max = lines;
+    }
+    stats.count++;
+    stats.total += lines;
+    u16 bucket = lines / LATENCY_BUCKET_LINES;
+    stats.buckets[bucket < LATENCY_BUCKET_COUNT ? bucket : LATENCY_BUCKET_COUNT - 1]++;
+    newSample = true;
+}
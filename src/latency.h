@@ -0,0 +1,21 @@
+#pragma once
+#include <genesis.h>
+#include <stdbool.h>
+
+#define LATENCY_BUCKET_COUNT 32
+#define LATENCY_BUCKET_LINES 32
+
+typedef struct
+{
+    u16 count;
+    u16 min;
+    u16 max;
+    u32 total;
+    u16 buckets[LATENCY_BUCKET_COUNT];
+} LatencyStats;
+
+void latency_markInput(u8 chanNumber);
+void latency_traceWrite(u8 part, u8 reg, u8 data);
+void latency_reset(void);
+bool latency_hasNewSample(void);
+const LatencyStats *latency_stats(void);
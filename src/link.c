@@ -0,0 +1,47 @@
+#include <genesis.h>
+#include <link.h>
+#include <synth.h>
+
+/*
+ * Link groups are bitmasks: one of channels, and one of operators for each
+ * channel. An edit to a linked member is applied to every member of its
+ * group, an edit to an unlinked one only to itself.
+ */
+static u8 linkedChannels = 0;
+static u8 linkedOperators[CHANNEL_COUNT];
+
+void link_toggleChannel(Channel *chan) { linkedChannels ^= 1 << chan->number; }
+
+void link_toggleOperator(Channel *chan, u8 opNumber)
+{
+    linkedOperators[chan->number] ^= 1 << opNumber;
+}
+
+bool link_isChannelLinked(Channel *chan) { return linkedChannels & (1 << chan->number); }
+
+bool link_isOperatorLinked(Channel *chan, u8 opNumber)
+{
+    return linkedOperators[chan->number] & (1 << opNumber);
+}
+
+u8 link_channels(Channel *chan)
+{
+    return link_isChannelLinked(chan) ? linkedChannels : 1 << chan->number;
+}
+
+u8 link_operators(Channel *chan, u8 opNumber)
+{
+    return link_isOperatorLinked(chan, opNumber) ? linkedOperators[chan->number] : 1 << opNumber;
+}
+
+void link_snapshot(u8 *data)
+{
+    data[0] = linkedChannels;
+    memcpy(data + 1, linkedOperators, CHANNEL_COUNT);
+}
+
+void link_restore(const u8 *data)
+{
+    linkedChannels = data[0];
+    memcpy(linkedOperators, data + 1, CHANNEL_COUNT);
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <channel.h>
+#include <genesis.h>
+#include <stdbool.h>
+#include <synth.h>
+
+#define LINK_SNAPSHOT_SIZE (1 + CHANNEL_COUNT)
+
+void link_toggleChannel(Channel *chan);
+void link_toggleOperator(Channel *chan, u8 opNumber);
+bool link_isChannelLinked(Channel *chan);
+bool link_isOperatorLinked(Channel *chan, u8 opNumber);
+u8 link_channels(Channel *chan);
+u8 link_operators(Channel *chan, u8 opNumber);
+void link_snapshot(u8 *data);
+void link_restore(const u8 *data);
@@ -0,0 +1,81 @@
+#include <genesis.h>
+#include <lz.h>
+
+/*
+ * LZSS with a 256 byte window, as produced by tools/lzpack:
+ *   u32 (big endian)  decoded size
+ *   flag byte         next eight items, least significant bit first
+ *   1: literal        one byte
+ *   0: match          two bytes, distance - 1 and length - LZ_MIN_MATCH
+ * Nothing is decoded ahead of the reader, so an asset can be consumed a few
+ * bytes a frame with only the window held in RAM.
+ */
+
+static u8 nextByte(LzStream *stream);
+static u8 copyMatchByte(LzStream *stream);
+
+void lz_open(LzStream *stream, const u8 *source)
+{
+    stream->remaining = ((u32)source[0] << 24) | ((u32)source[1] << 16)
+        | ((u32)source[2] << 8) | source[3];
+    stream->source = source + LZ_HEADER_SIZE;
+    stream->position = 0;
+    stream->flags = 0;
+    stream->flagCount = 0;
+    stream->matchLength = 0;
+}
+
+u16 lz_read(LzStream *stream, u8 *dest, u16 count)
+{
+    u16 read = 0;
+    while (read < count && stream->remaining != 0)
+    {
+        dest[read++] = nextByte(stream);
+        stream->remaining--;
+    }
+    return read;
+}
+
+u32 lz_remaining(const LzStream *stream)
+{
+    return stream->remaining;
+}
+
+bool lz_done(const LzStream *stream)
+{
+    return stream->remaining == 0;
+}
+
+static u8 nextByte(LzStream *stream)
+{
+    if (stream->matchLength != 0)
+    {
+        return copyMatchByte(stream);
+    }
+    if (stream->flagCount == 0)
+    {
+        stream->flags = *stream->source++;
+        stream->flagCount = 8;
+    }
+    bool literal = stream->flags & 1;
+    stream->flags >>= 1;
+    stream->flagCount--;
+    if (literal)
+    {
+        u8 value = *stream->source++;
+        stream->window[stream->position++] = value;
+        return value;
+    }
+    stream->matchDistance = stream->source[0] + 1;
+    stream->matchLength = stream->source[1] + LZ_MIN_MATCH;
+    stream->source += 2;
+    return copyMatchByte(stream);
+}
+
+static u8 copyMatchByte(LzStream *stream)
+{
+    u8 value = stream->window[(u8)(stream->position - stream->matchDistance)];
+    stream->window[stream->position++] = value;
+    stream->matchLength--;
+    return value;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <genesis.h>
+#include <stdbool.h>
+
+#define LZ_WINDOW_SIZE 256
+#define LZ_HEADER_SIZE 4
+#define LZ_MIN_MATCH 3
+
+typedef struct
+{
+    const u8 *source;
+    u32 remaining;
+    u8 window[LZ_WINDOW_SIZE];
+    u8 position;
+    u8 flags;
+    u8 flagCount;
+    u16 matchDistance;
+    u16 matchLength;
+} LzStream;
+
+void lz_open(LzStream *stream, const u8 *source);
+u16 lz_read(LzStream *stream, u8 *dest, u16 count);
+u32 lz_remaining(const LzStream *stream);
+bool lz_done(const LzStream *stream);
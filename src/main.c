@@ -1,17 +1,38 @@
+#include <automation.h>
+#include <envelope.h>
 #include <genesis.h>
-#include <presets.h>
+#include <megadrive.h>
+#include <midi.h>
+#include <patch.h>
+#include <preset_bank.h>
+#include <profiler.h>
+#include <scheduler.h>
+#include <storage.h>
 #include <synth.h>
 #include <ui.h>
 
 int main(void)
 {
+    profiler_init();
+    envelope_init();
     synth_init();
-    synth_preset(&PRESET_CASTLEVANIA);
+    patch_loadPreset(PRESET_BANK, PRESET_CASTLEVANIA_NUMBER);
+    storage_load();
     ui_init();
+    scheduler_init();
     while (TRUE)
     {
-        VDP_showFPS(FALSE);
         ui_checkInput();
+        automation_update();
+        midi_update();
+        synth_updateGlides();
+        envelope_update();
+        scheduler_poll();
+        storage_update();
+        megadrive_flushWrites();
+        megadrive_endFrame();
+        profiler_endFrame();
+        midi_pollUntilVBlank();
         SYS_doVBlankProcess();
     }
 }
@@ -1,6 +1,283 @@
+#include <latency.h>
 #include <megadrive.h>
+#include <ports.h>
+#include <profiler.h>
+#include <replay.h>
+
+#define PART_COUNT 2
+#define REGISTER_COUNT 256
+#define QUEUED 0x01
+#define SHADOWED 0x02
+#define CLASS_SHIFT 2
+#define CLASS_MASK 0x0C
+#define YM2612_BUSY 0x80
+#define KEY_ON_OFF_REG 0x28
+#define KEY_ON_MASK 0xF0
+#define CHANNEL_CODE_MASK 0x07
+#define FIRST_OPERATOR_REG 0x30
+#define LAST_OPERATOR_REG 0x9F
+#define ALGORITHM_REG 0xB0
+#define STEREO_REG 0xB4
+
+/*
+ * Key on/off, pitch and the global registers are written straight away.
+ * Everything else is queued by priority class (envelope, then timbre, then
+ * bulk loads such as presets) and drained once a frame within a write
+ * budget, so a burst of patch traffic spills into later frames instead of
+ * delaying notes. A register already queued only has its value replaced,
+ * unless the new write is of a more urgent class: it then moves to that
+ * class's queue, and the entry left behind is skipped when drained. A
+ * queued value matching what the chip already holds is dropped. Queues are
+ * 256-entry rings indexed by u8 so they wrap for free. Key writes are never
+ * queued, and keying a channel on first writes out anything still queued
+ * for it, so a note never starts with a stale patch.
+ *
+ * For the write statistics page, requested writes are counted per register
+ * in saturating byte counters, and each real write counts the status polls
+ * spent waiting for the chip to stop being busy. Both are only kept while
+ * the page is enabled, so the write path costs nothing extra otherwise.
+ */
+typedef struct
+{
+    u16 entries[REGISTER_COUNT];
+    u8 head;
+    u8 tail;
+} WriteQueue;
+
+static void writeRegister(u8 part, u8 reg, u8 data);
+static void enqueue(u8 part, u8 reg, u8 data, WriteClass writeClass);
+static void flushChannel(u8 channelCode);
+static void flushRegister(u8 part, u8 reg);
+static void drain(u16 budget);
+static WriteClass registerClass(u8 reg);
+
+static WriteQueue queues[WRITE_CLASS_COUNT - 1];
+static u8 registerFlags[PART_COUNT][REGISTER_COUNT];
+static u8 queuedValues[PART_COUNT][REGISTER_COUNT];
+static u8 shadowValues[PART_COUNT][REGISTER_COUNT];
+static u8 bulkDepth = 0;
+static u16 writeBudget = MEGADRIVE_WRITE_BUDGET;
+static u8 requestCounts[PART_COUNT][REGISTER_COUNT];
+static WriteStats stats;
+static u16 frameWrites = 0;
+static u32 busyPolls = 0;
+static bool statsEnabled = FALSE;
 
 void megadrive_writeToYm2612(u8 channel, u8 baseReg, u8 data)
 {
-    YM2612_writeReg(channel > 2 ? 1 : 0, baseReg + (channel % 3), data);
+    megadrive_writeToYm2612Part(channel > 2 ? 1 : 0, baseReg + (channel % 3), data);
+}
+
+void megadrive_writeToYm2612Part(u8 part, u8 reg, u8 data)
+{
+    if (statsEnabled)
+    {
+        u8 *count = &requestCounts[part][reg];
+        if (*count != 0xFF)
+        {
+            (*count)++;
+        }
+        stats.requests++;
+    }
+    WriteClass writeClass = registerClass(reg);
+    if (writeClass == WRITE_CLASS_KEY)
+    {
+        if (reg == KEY_ON_OFF_REG && (data & KEY_ON_MASK))
+        {
+            flushChannel(data & CHANNEL_CODE_MASK);
+        }
+        writeRegister(part, reg, data);
+        return;
+    }
+    if (bulkDepth > 0)
+    {
+        writeClass = WRITE_CLASS_BULK;
+    }
+    SYS_disableInts();
+    u8 flags = registerFlags[part][reg];
+    if (flags & QUEUED)
+    {
+        queuedValues[part][reg] = data;
+        if (writeClass < (WriteClass)((flags & CLASS_MASK) >> CLASS_SHIFT))
+        {
+            enqueue(part, reg, data, writeClass);
+        }
+    }
+    else if (!((flags & SHADOWED) && shadowValues[part][reg] == data))
+    {
+        enqueue(part, reg, data, writeClass);
+    }
+    SYS_enableInts();
+}
+
+u8 megadrive_readYm2612Status(void) { return PORT_READ_U8(YM2612_BASEPORT); }
+
+void megadrive_beginBulkWrites(void) { bulkDepth++; }
+
+void megadrive_endBulkWrites(void) { bulkDepth--; }
+
+void megadrive_setWriteBudget(u16 writesPerFrame) { writeBudget = writesPerFrame; }
+
+/* Key writes are timed by the profiler section that makes them, not here */
+void megadrive_flushWrites(void)
+{
+    profiler_begin(PROFILER_YM2612);
+    drain(writeBudget);
+    profiler_end(PROFILER_YM2612);
+}
+
+void megadrive_drainWrites(void) { drain(0xFFFF); }
+
+u16 megadrive_writeBacklog(WriteClass writeClass)
+{
+    if (writeClass == WRITE_CLASS_KEY)
+    {
+        return 0;
+    }
+    WriteQueue *queue = &queues[writeClass - 1];
+    return (u8)(queue->tail - queue->head);
+}
+
+void megadrive_endFrame(void)
+{
+    if (statsEnabled)
+    {
+        stats.frameWrites = frameWrites;
+        if (frameWrites > stats.peakFrameWrites)
+        {
+            stats.peakFrameWrites = frameWrites;
+        }
+    }
+    frameWrites = 0;
+}
+
+const WriteStats *megadrive_writeStats(void)
+{
+    stats.averageBusy = stats.writes > 0 ? busyPolls / stats.writes : 0;
+    return &stats;
+}
+
+const u8 *megadrive_requestCounts(u8 part) { return requestCounts[part]; }
+
+void megadrive_setWriteStatsEnabled(bool enabled)
+{
+    statsEnabled = enabled;
+    megadrive_clearWriteStats();
+}
+
+void megadrive_clearWriteStats(void)
+{
+    memset(requestCounts, 0, sizeof(requestCounts));
+    stats.requests = 0;
+    stats.writes = 0;
+    stats.peakFrameWrites = 0;
+    stats.peakBusy = 0;
+    busyPolls = 0;
+}
+
+static void enqueue(u8 part, u8 reg, u8 data, WriteClass writeClass)
+{
+    WriteQueue *queue = &queues[writeClass - 1];
+    u8 *flags = &registerFlags[part][reg];
+    if ((u8)(queue->tail + 1) == queue->head)
+    {
+        *flags &= ~QUEUED;
+        writeRegister(part, reg, data);
+        return;
+    }
+    queue->entries[queue->tail++] = (part << 8) | reg;
+    queuedValues[part][reg] = data;
+    *flags = (*flags & ~CLASS_MASK) | QUEUED | (writeClass << CLASS_SHIFT);
+}
+
+/* Writes out the operator and channel registers still queued for a key code */
+static void flushChannel(u8 channelCode)
+{
+    u8 part = channelCode >> 2;
+    u8 channel = channelCode & 3;
+    SYS_disableInts();
+    for (u8 reg = FIRST_OPERATOR_REG + channel; reg <= LAST_OPERATOR_REG; reg += 4)
+    {
+        flushRegister(part, reg);
+    }
+    flushRegister(part, ALGORITHM_REG + channel);
+    flushRegister(part, STEREO_REG + channel);
+    SYS_enableInts();
+}
+
+static void flushRegister(u8 part, u8 reg)
+{
+    u8 *flags = &registerFlags[part][reg];
+    if (*flags & QUEUED)
+    {
+        *flags &= ~QUEUED;
+        writeRegister(part, reg, queuedValues[part][reg]);
+    }
+}
+
+static void drain(u16 budget)
+{
+    for (u8 c = WRITE_CLASS_ENVELOPE; c < WRITE_CLASS_COUNT; c++)
+    {
+        WriteQueue *queue = &queues[c - 1];
+        while (budget > 0 && queue->head != queue->tail)
+        {
+            SYS_disableInts();
+            u16 entry = queue->entries[queue->head++];
+            u8 part = entry >> 8;
+            u8 reg = entry;
+            u8 flags = registerFlags[part][reg];
+            if ((flags & QUEUED) && (flags & CLASS_MASK) >> CLASS_SHIFT == c)
+            {
+                flushRegister(part, reg);
+                budget--;
+            }
+            SYS_enableInts();
+        }
+    }
+}
+
+static void writeRegister(u8 part, u8 reg, u8 data)
+{
+    SYS_disableInts();
+    if (statsEnabled)
+    {
+        u16 polls = 0;
+        while (megadrive_readYm2612Status() & YM2612_BUSY)
+        {
+            polls++;
+        }
+        busyPolls += polls;
+        if (polls > stats.peakBusy)
+        {
+            stats.peakBusy = polls;
+        }
+        stats.writes++;
+    }
+    else
+    {
+        while (megadrive_readYm2612Status() & YM2612_BUSY)
+        {
+        }
+    }
+    frameWrites++;
+    YM2612_writeReg(part, reg, data);
+    replay_traceWrite(part, reg, data);
+    latency_traceWrite(part, reg, data);
+    shadowValues[part][reg] = data;
+    registerFlags[part][reg] |= SHADOWED;
+    SYS_enableInts();
+}
+
+static WriteClass registerClass(u8 reg)
+{
+    if (reg < 0x30 || (reg >= 0xA0 && reg < 0xB0))
+    {
+        return WRITE_CLASS_KEY;
+    }
+    if (reg >= 0x40 && reg < 0xA0)
+    {
+        return WRITE_CLASS_ENVELOPE;
+    }
+    return WRITE_CLASS_TIMBRE;
 }
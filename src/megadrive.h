@@ -1,3 +1,38 @@
+#pragma once
 #include <genesis.h>
 
+#define MEGADRIVE_WRITE_BUDGET 48
+
+typedef enum {
+    WRITE_CLASS_KEY,
+    WRITE_CLASS_ENVELOPE,
+    WRITE_CLASS_TIMBRE,
+    WRITE_CLASS_BULK
+} WriteClass;
+
+#define WRITE_CLASS_COUNT 4
+
+typedef struct
+{
+    u16 requests;
+    u16 writes;
+    u16 frameWrites;
+    u16 peakFrameWrites;
+    u16 averageBusy;
+    u16 peakBusy;
+} WriteStats;
+
 void megadrive_writeToYm2612(u8 channel, u8 baseReg, u8 data);
+void megadrive_writeToYm2612Part(u8 part, u8 reg, u8 data);
+u8 megadrive_readYm2612Status(void);
+void megadrive_beginBulkWrites(void);
+void megadrive_endBulkWrites(void);
+void megadrive_setWriteBudget(u16 writesPerFrame);
+void megadrive_flushWrites(void);
+void megadrive_drainWrites(void);
+u16 megadrive_writeBacklog(WriteClass writeClass);
+void megadrive_endFrame(void);
+const WriteStats *megadrive_writeStats(void);
+const u8 *megadrive_requestCounts(u8 part);
+void megadrive_setWriteStatsEnabled(bool enabled);
+void megadrive_clearWriteStats(void);
@@ -0,0 +1,320 @@
+#include <arpeggiator.h>
+#include <ch3voice.h>
+#include <channel.h>
+#include <genesis.h>
+#include <midi.h>
+#include <pitch.h>
+#include <ports.h>
+#include <profiler.h>
+#include <synth.h>
+
+#define PORT2_RX_DATA 0xA10017
+#define PORT2_SERIAL_CTRL 0xA10019
+#define SERIAL_4800_BPS 0x00
+#define SERIAL_IN 0x20
+#define SERIAL_RX_INT 0x08
+#define SERIAL_RX_ERROR 0x04
+#define SERIAL_RX_READY 0x02
+#define VDP_MODE_REG_3 11
+#define VDP_EXT_INT_ENABLE 0x08
+#define EXT_INT_LEVEL 2
+#define POLL_MARGIN_LINES 8
+
+#define STATUS_NOTE_OFF 0x80
+#define STATUS_NOTE_ON 0x90
+#define STATUS_CONTROL_CHANGE 0xB0
+#define STATUS_PROGRAM_CHANGE 0xC0
+#define STATUS_CHANNEL_PRESSURE 0xD0
+#define STATUS_PITCH_BEND 0xE0
+#define STATUS_SYSTEM 0xF0
+#define STATUS_REALTIME 0xF8
+#define NO_NOTE 0xFF
+#define CONTROLLER_COUNT 14
+#define FM_SELECTION (GLOBAL_PARAMETER_COUNT + ARP_PARAMETER_COUNT)
+#define OP_SELECTION(op, parameter) \
+    (FM_SELECTION + FM_PARAMETER_COUNT + (op) * OPERATOR_PARAMETER_COUNT + (parameter))
+
+/*
+ * Bytes arrive on controller port 2's serial input at 4800 bps, one every
+ * ~2 ms. The external interrupt only pushes them into a ring. The main loop
+ * parses and dispatches them with midi_poll, and keeps polling after the
+ * frame's work until 8 lines before VBlank, so a note is keyed within a poll
+ * of arriving, or at the start of the next frame's work if it arrives in
+ * VBlank or during the work. That is under a frame on both regions, and
+ * never at interrupt level.
+ * MIDI channels 1-6 drive FM channels 1-6, with channel 3 polyphonic when it
+ * is in four-voice mode. Controller and pitch bend values are applied once
+ * each per frame by midi_update.
+ */
+typedef struct
+{
+    u8 number;
+    u8 selection;
+} Controller;
+
+static const Controller CONTROLLERS[CONTROLLER_COUNT] = {
+    {14, FM_SELECTION + PARAMETER_ALGORITHM},
+    {15, FM_SELECTION + PARAMETER_FEEDBACK},
+    {16, OP_SELECTION(0, OP_PARAMETER_TL)},
+    {17, OP_SELECTION(1, OP_PARAMETER_TL)},
+    {18, OP_SELECTION(2, OP_PARAMETER_TL)},
+    {19, OP_SELECTION(3, OP_PARAMETER_TL)},
+    {20, OP_SELECTION(0, OP_PARAMETER_MUL)},
+    {21, OP_SELECTION(1, OP_PARAMETER_MUL)},
+    {22, OP_SELECTION(2, OP_PARAMETER_MUL)},
+    {23, OP_SELECTION(3, OP_PARAMETER_MUL)},
+    {10, FM_SELECTION + PARAMETER_STEREO},
+    {1, FM_SELECTION + PARAMETER_LFO_FMS},
+    {5, FM_SELECTION + PARAMETER_GLIDE},
+    {68, FM_SELECTION + PARAMETER_LEGATO}};
+
+static void receive(void);
+static void push(u8 byte);
+static void parse(u8 byte);
+static void dispatch(void);
+static void noteOn(u8 chanNumber, u8 midiNote, u8 velocity);
+static void noteOff(u8 chanNumber, u8 midiNote);
+static void controlChange(u8 chanNumber, u8 number, u8 value);
+static void updatePitch(u8 chanNumber);
+static u16 selectionMaxValue(u8 chanNumber, u8 selection);
+
+static volatile u8 ring[MIDI_RING_SIZE];
+static volatile u8 ringHead = 0;
+static volatile u8 ringTail = 0;
+static u8 status = 0;
+static u8 data[2];
+static u8 dataCount = 0;
+static u8 heldNotes[CHANNEL_COUNT];
+static u8 voiceNotes[CH3_VOICE_COUNT];
+static s16 bends[CHANNEL_COUNT];
+static u8 controllerValues[CHANNEL_COUNT][CONTROLLER_COUNT];
+static u16 controllersChanged[CHANNEL_COUNT];
+static u8 bendsChanged = 0;
+static MidiParameterWrite writeParameter;
+
+void midi_init(MidiParameterWrite write)
+{
+    writeParameter = write;
+    memset(heldNotes, NO_NOTE, sizeof(heldNotes));
+    memset(voiceNotes, NO_NOTE, sizeof(voiceNotes));
+    SYS_setExtIntCallback(receive);
+    /* The serial receive interrupt needs no TH interrupt enable in the port's control register */
+    PORT_WRITE_U8(PORT2_SERIAL_CTRL, SERIAL_4800_BPS | SERIAL_IN | SERIAL_RX_INT);
+    VDP_setReg(VDP_MODE_REG_3, VDP_getReg(VDP_MODE_REG_3) | VDP_EXT_INT_ENABLE);
+    /* SGDK leaves the mask at level 3, which blocks the level 2 external interrupt */
+    SYS_setInterruptMaskLevel(EXT_INT_LEVEL - 1);
+}
+
+/* Feeds a byte in as if it had been received, for testing without a cable */
+void midi_inject(u8 byte)
+{
+    SYS_disableInts();
+    push(byte);
+    SYS_enableInts();
+}
+
+void midi_poll(void)
+{
+    while (ringTail != ringHead)
+    {
+        parse(ring[ringTail]);
+        ringTail++;
+    }
+}
+
+/*
+ * The next VBlank interrupt is a frame after the profiler's VBlank time. A
+ * poll with a message to dispatch takes well under the margin, so the loop
+ * never runs into the interrupt SYS_doVBlankProcess waits for.
+ */
+void midi_pollUntilVBlank(void)
+{
+    u32 deadline = profiler_vblankTime()
+        + ((u32)(profiler_frameLines() - POLL_MARGIN_LINES) << PROFILER_LINE_SHIFT);
+    while ((s32)(deadline - profiler_timestamp()) > 0)
+    {
+        midi_poll();
+    }
+}
+
+void midi_update(void)
+{
+    midi_poll();
+    for (u8 c = 0; c < CHANNEL_COUNT; c++)
+    {
+        u16 changed = controllersChanged[c];
+        controllersChanged[c] = 0;
+        for (u8 i = 0; changed != 0; i++, changed >>= 1)
+        {
+            if (changed & 1)
+            {
+                u8 selection = CONTROLLERS[i].selection;
+                u16 maxValue = selectionMaxValue(c, selection);
+                writeParameter(c, selection, (controllerValues[c][i] * (maxValue + 1)) >> 7);
+            }
+        }
+        if (bendsChanged & (1 << c))
+        {
+            bendsChanged &= ~(1 << c);
+            updatePitch(c);
+        }
+    }
+}
+
+static void receive(void)
+{
+    u8 serialStatus;
+    while ((serialStatus = PORT_READ_U8(PORT2_SERIAL_CTRL)) & SERIAL_RX_READY)
+    {
+        u8 byte = PORT_READ_U8(PORT2_RX_DATA);
+        if (!(serialStatus & SERIAL_RX_ERROR))
+        {
+            push(byte);
+        }
+    }
+}
+
+static void push(u8 byte)
+{
+    if ((u8)(ringHead + 1) != ringTail)
+    {
+        ring[ringHead] = byte;
+        ringHead++;
+    }
+}
+
+static void parse(u8 byte)
+{
+    if (byte >= STATUS_REALTIME)
+    {
+        return;
+    }
+    if (byte & 0x80)
+    {
+        status = byte < STATUS_SYSTEM ? byte : 0;
+        dataCount = 0;
+        return;
+    }
+    if (status == 0)
+    {
+        return;
+    }
+    data[dataCount++] = byte;
+    u8 type = status & 0xF0;
+    u8 length = (type == STATUS_PROGRAM_CHANGE || type == STATUS_CHANNEL_PRESSURE) ? 1 : 2;
+    if (dataCount == length)
+    {
+        dataCount = 0;
+        dispatch();
+    }
+}
+
+static void dispatch(void)
+{
+    u8 chanNumber = status & 0x0F;
+    if (chanNumber >= CHANNEL_COUNT)
+    {
+        return;
+    }
+    switch (status & 0xF0)
+    {
+    case STATUS_NOTE_ON:
+        if (data[1] != 0)
+        {
+            noteOn(chanNumber, data[0], data[1]);
+            break;
+        }
+        noteOff(chanNumber, data[0]);
+        break;
+    case STATUS_NOTE_OFF:
+        noteOff(chanNumber, data[0]);
+        break;
+    case STATUS_CONTROL_CHANGE:
+        controlChange(chanNumber, data[0], data[1]);
+        break;
+    case STATUS_PITCH_BEND:
+        bends[chanNumber] = ((data[1] << 7) | data[0]) - 0x2000;
+        bendsChanged |= 1 << chanNumber;
+        break;
+    default:
+        break;
+    }
+}
+
+static void noteOn(u8 chanNumber, u8 midiNote, u8 velocity)
+{
+    if (chanNumber == CH3_VOICE_CHANNEL && ch3voice_isAvailable())
+    {
+        u8 voice = ch3voice_allocate();
+        u8 note, octave;
+        pitch_fromMidi(midiNote, &note, &octave);
+        voiceNotes[voice] = midiNote;
+        ch3voice_noteOn(voice, note, octave, velocity);
+        return;
+    }
+    u8 note, octave;
+    pitch_fromMidi(midiNote, &note, &octave);
+    u16 freq = pitch_bentFrequency(note, &octave, bends[chanNumber]);
+    Channel *chan = synth_channel(chanNumber);
+    heldNotes[chanNumber] = midiNote;
+    channel_setVelocity(chan, velocity);
+    channel_playFrequency(chan, freq, octave);
+}
+
+static void noteOff(u8 chanNumber, u8 midiNote)
+{
+    if (chanNumber == CH3_VOICE_CHANNEL)
+    {
+        for (u8 v = 0; v < CH3_VOICE_COUNT; v++)
+        {
+            if (voiceNotes[v] == midiNote)
+            {
+                voiceNotes[v] = NO_NOTE;
+                ch3voice_noteOff(v);
+            }
+        }
+    }
+    if (heldNotes[chanNumber] == midiNote)
+    {
+        heldNotes[chanNumber] = NO_NOTE;
+        channel_keyOff(synth_channel(chanNumber));
+    }
+}
+
+static void controlChange(u8 chanNumber, u8 number, u8 value)
+{
+    for (u8 i = 0; i < CONTROLLER_COUNT; i++)
+    {
+        if (CONTROLLERS[i].number == number)
+        {
+            controllerValues[chanNumber][i] = value;
+            controllersChanged[chanNumber] |= 1 << i;
+            return;
+        }
+    }
+}
+
+static void updatePitch(u8 chanNumber)
+{
+    u8 midiNote = heldNotes[chanNumber];
+    if (midiNote == NO_NOTE)
+    {
+        return;
+    }
+    u8 note, octave;
+    pitch_fromMidi(midiNote, &note, &octave);
+    u16 freq = pitch_bentFrequency(note, &octave, bends[chanNumber]);
+    channel_setFrequency(synth_channel(chanNumber), freq, octave);
+}
+
+static u16 selectionMaxValue(u8 chanNumber, u8 selection)
+{
+    Channel *chan = synth_channel(chanNumber);
+    if (selection < FM_SELECTION + FM_PARAMETER_COUNT)
+    {
+        return channel_parameterMaxValue(chan, selection - FM_SELECTION);
+    }
+    selection -= FM_SELECTION + FM_PARAMETER_COUNT;
+    Operator *op = channel_operator(chan, selection / OPERATOR_PARAMETER_COUNT);
+    return operator_parameterMaxValue(op, selection % OPERATOR_PARAMETER_COUNT);
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include <genesis.h>
+
+#define MIDI_RING_SIZE 256
+
+typedef void (*MidiParameterWrite)(u8 chanNumber, u8 selection, u16 value);
+
+void midi_init(MidiParameterWrite write);
+void midi_inject(u8 byte);
+void midi_poll(void);
+void midi_pollUntilVBlank(void);
+void midi_update(void);
@@ -1,6 +1,10 @@
 #include <operator.h>
 #include <genesis.h>
 #include <megadrive.h>
+#include <synth.h>
+
+#define CH3_CHANNEL 2
+#define TOTAL_LEVEL_MAX 127
 
 static void updateMulDt1(Operator *op);
 static void updateTotalLevel(Operator *op);
@@ -42,6 +46,7 @@ void operator_init(Operator *op, u8 opNumber, u8 chanNumber, const u16 parameter
     op->opNumber = opNumber;
     op->chanNumber = chanNumber;
     op->parameters = &parameters[0];
+    op->attenuation = 0;
     for (int i = 0; i < OPERATOR_PARAMETER_COUNT; i++)
     {
         op->parameterValues[i] = parameterValues[i];
@@ -53,6 +58,11 @@ u16 operator_parameterValue(Operator *op, OpParameters parameter)
     return op->parameterValues[parameter];
 }
 
+u16 operator_parameterMaxValue(Operator *op, OpParameters parameter)
+{
+    return op->parameters[parameter].maxValue;
+}
+
 void operator_setParameterValue(Operator *op, OpParameters parameter, u16 value)
 {
     const OperatorParameter *p = &op->parameters[parameter];
@@ -68,6 +78,21 @@ void operator_setParameterValue(Operator *op, OpParameters parameter, u16 value)
     op->parameters[parameter].onUpdate(op);
 }
 
+void operator_setFrequency(Operator *op, u8 octave, u16 freq)
+{
+    setFreqAndOctave(op, octave, freq);
+}
+
+/* Sets an attenuation added to the total level, such as for velocity */
+void operator_setAttenuation(Operator *op, u8 attenuation)
+{
+    if (op->attenuation != attenuation)
+    {
+        op->attenuation = attenuation;
+        updateTotalLevel(op);
+    }
+}
+
 void operator_update(Operator *op)
 {
     updateMulDt1(op);
@@ -89,9 +114,10 @@ static void updateMulDt1(Operator *op)
 
 static void updateTotalLevel(Operator *op)
 {
+    u16 totalLevel = op->parameterValues[OP_PARAMETER_TL] + op->attenuation;
     setTotalLevel(
         op,
-        op->parameterValues[OP_PARAMETER_TL]);
+        totalLevel > TOTAL_LEVEL_MAX ? TOTAL_LEVEL_MAX : totalLevel);
 }
 
 static void updateRsAr(Operator *op)
@@ -163,27 +189,33 @@ static void setD1lRr(Operator *op, u8 d1l, u8 rr)
     megadrive_writeToYm2612(op->chanNumber, 0x80 + (op->opNumber * 4), rr | (d1l << 4));
 }
 
+/* Only channel 3's operators have their own frequencies, and only in special mode */
 static void setFreqAndOctave(Operator *op, u8 octave, u16 freq)
 {
-    u8 lower_reg, upper_reg;
-    if (op->opNumber == 1)
+    if (op->chanNumber != CH3_CHANNEL || !synth_isCh3SpecialMode())
     {
-        lower_reg = 0xA8;
-        upper_reg = 0xAC;
+        return;
     }
-    else if (op->opNumber == 2)
+    u8 lower_reg, upper_reg;
+    if (op->opNumber == 0)
     {
         lower_reg = 0xA9;
         upper_reg = 0xAD;
     }
-    else if (op->opNumber == 3)
+    else if (op->opNumber == 1)
+    {
+        lower_reg = 0xA8;
+        upper_reg = 0xAC;
+    }
+    else if (op->opNumber == 2)
     {
         lower_reg = 0xAA;
         upper_reg = 0xAE;
     }
     else
     {
-        return;
+        lower_reg = 0xA2;
+        upper_reg = 0xA6;
     }
     megadrive_writeToYm2612(0, upper_reg, (freq >> 8) | (octave << 3));
     megadrive_writeToYm2612(0, lower_reg, freq);
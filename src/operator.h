@@ -2,6 +2,7 @@
 #include <genesis.h>
 
 #define OPERATOR_PARAMETER_COUNT 12
+#define CH3_CHANNEL_OPERATOR 3
 
 typedef enum {
     OP_PARAMETER_DT1,
@@ -27,10 +28,14 @@ struct Operator
     u8 chanNumber;
     OperatorParameter const *parameters;
     u16 parameterValues[OPERATOR_PARAMETER_COUNT];
+    u8 attenuation;
 };
 
 void operator_init(Operator *op, u8 opNumber, u8 chanNumber, const u16 parameterValues[OPERATOR_PARAMETER_COUNT]);
 u16 operator_parameterValue(Operator *op, OpParameters parameter);
+u16 operator_parameterMaxValue(Operator *op, OpParameters parameter);
 void operator_parameterUpdate(Operator *op, OpParameters parameter);
 void operator_setParameterValue(Operator *op, OpParameters parameter, u16 value);
 void operator_update(Operator *op);
+void operator_setFrequency(Operator *op, u8 octave, u16 freq);
+void operator_setAttenuation(Operator *op, u8 attenuation);
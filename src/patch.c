@@ -0,0 +1,173 @@
+#include <channel.h>
+#include <genesis.h>
+#include <lz.h>
+#include <megadrive.h>
+#include <operator.h>
+#include <patch.h>
+#include <synth.h>
+
+/*
+ * Parameters are bit-packed MSB first, each using just enough bits to hold
+ * its maximum value, in the same order as the Preset structure.
+ *
+ * PACKED_CHANNEL_BITS adds up those widths for the channel parameter table in
+ * channel.c and the operator table in operator.c, and has to be kept in step
+ * with them; the count check fails when a parameter is added without doing so.
+ */
+#define PACKED_FM_BITS (4 + 11 + 3 + 3 + 3 + 2 + 3 + 2 + 5 + 1)
+#define PACKED_OPERATOR_BITS (3 + 4 + 7 + 2 + 5 + 1 + 5 + 5 + 4 + 4 + 3 + 11)
+#define PACKED_CHANNEL_BITS (PACKED_FM_BITS + OPERATOR_COUNT * PACKED_OPERATOR_BITS)
+
+_Static_assert(FM_PARAMETER_COUNT == 10 && OPERATOR_PARAMETER_COUNT == 12,
+               "PACKED_CHANNEL_BITS is out of date");
+_Static_assert(PACKED_CHANNEL_BITS <= PATCH_CHANNEL_SIZE * 8,
+               "a packed channel no longer fits in PATCH_CHANNEL_SIZE");
+
+static LzStream bankStream;
+static u8 bankBuffer[PATCH_CHANNEL_SIZE];
+
+static u8 bitWidth(u16 maxValue);
+static bool readBlock(u16 size);
+static void writeBits(u8 *data, u16 *bitPos, u16 value, u8 width);
+static u16 readBits(const u8 *data, u16 *bitPos, u8 width);
+
+void patch_packChannel(Channel *chan, u8 *data)
+{
+    u16 bitPos = 0;
+    memset(data, 0, PATCH_CHANNEL_SIZE);
+    for (u16 p = 0; p < FM_PARAMETER_COUNT; p++)
+    {
+        writeBits(data, &bitPos, channel_parameterValue(chan, p),
+                  bitWidth(channel_parameterMaxValue(chan, p)));
+    }
+    for (u16 o = 0; o < OPERATOR_COUNT; o++)
+    {
+        Operator *op = channel_operator(chan, o);
+        for (u16 p = 0; p < OPERATOR_PARAMETER_COUNT; p++)
+        {
+            writeBits(data, &bitPos, operator_parameterValue(op, p),
+                      bitWidth(operator_parameterMaxValue(op, p)));
+        }
+    }
+}
+
+void patch_unpackChannel(Channel *chan, const u8 *data)
+{
+    u16 bitPos = 0;
+    for (u16 p = 0; p < FM_PARAMETER_COUNT; p++)
+    {
+        u16 value = readBits(data, &bitPos, bitWidth(channel_parameterMaxValue(chan, p)));
+        channel_setParameterValue(chan, p, value);
+    }
+    for (u16 o = 0; o < OPERATOR_COUNT; o++)
+    {
+        Operator *op = channel_operator(chan, o);
+        for (u16 p = 0; p < OPERATOR_PARAMETER_COUNT; p++)
+        {
+            u16 value = readBits(data, &bitPos, bitWidth(operator_parameterMaxValue(op, p)));
+            operator_setParameterValue(op, p, value);
+        }
+    }
+}
+
+void patch_packGlobals(u8 *data)
+{
+    u16 bitPos = 0;
+    memset(data, 0, PATCH_GLOBALS_SIZE);
+    for (u16 p = 0; p < GLOBAL_PARAMETER_COUNT; p++)
+    {
+        writeBits(data, &bitPos, synth_globalParameterValue(p),
+                  bitWidth(synth_globalParameterMaxValue(p)));
+    }
+}
+
+void patch_unpackGlobals(const u8 *data)
+{
+    u16 bitPos = 0;
+    for (u16 p = 0; p < GLOBAL_PARAMETER_COUNT; p++)
+    {
+        u16 value = readBits(data, &bitPos, bitWidth(synth_globalParameterMaxValue(p)));
+        synth_setGlobalParameterValue(p, value);
+    }
+}
+
+/*
+ * A preset bank is packed with tools/lzpack and holds, for each preset, the
+ * globals followed by the six channels. Presets before the one wanted are
+ * decoded and skipped; only a channel's worth of the bank is held at once.
+ */
+bool patch_loadPreset(const u8 *bank, u16 number)
+{
+    lz_open(&bankStream, bank);
+    for (u16 preset = 0; preset < number; preset++)
+    {
+        if (!readBlock(PATCH_GLOBALS_SIZE))
+        {
+            return false;
+        }
+        for (u8 c = 0; c < CHANNEL_COUNT; c++)
+        {
+            if (!readBlock(PATCH_CHANNEL_SIZE))
+            {
+                return false;
+            }
+        }
+    }
+    if (!readBlock(PATCH_GLOBALS_SIZE))
+    {
+        return false;
+    }
+    megadrive_beginBulkWrites();
+    patch_unpackGlobals(bankBuffer);
+    bool loaded = true;
+    for (u8 c = 0; c < CHANNEL_COUNT && loaded; c++)
+    {
+        loaded = readBlock(PATCH_CHANNEL_SIZE);
+        if (loaded)
+        {
+            patch_unpackChannel(synth_channel(c), bankBuffer);
+        }
+    }
+    megadrive_endBulkWrites();
+    return loaded;
+}
+
+static bool readBlock(u16 size) { return lz_read(&bankStream, bankBuffer, size) == size; }
+
+static u8 bitWidth(u16 maxValue)
+{
+    u8 width = 0;
+    while (maxValue)
+    {
+        width++;
+        maxValue >>= 1;
+    }
+    return width;
+}
+
+static void writeBits(u8 *data, u16 *bitPos, u16 value, u8 width)
+{
+    while (width--)
+    {
+        if (value & (1 << width))
+        {
+            data[*bitPos >> 3] |= 0x80 >> (*bitPos & 7);
+        }
+        (*bitPos)++;
+    }
+}
+
+static u16 readBits(const u8 *data, u16 *bitPos, u8 width)
+{
+    u16 value = 0;
+    while (width--)
+    {
+        value <<= 1;
+        if (data[*bitPos >> 3] & (0x80 >> (*bitPos & 7)))
+        {
+            value |= 1;
+        }
+        (*bitPos)++;
+    }
+    return value;
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <channel.h>
+#include <genesis.h>
+#include <stdbool.h>
+
+#define PATCH_CHANNEL_SIZE 32
+#define PATCH_GLOBALS_SIZE 1
+
+void patch_packChannel(Channel *chan, u8 *data);
+void patch_unpackChannel(Channel *chan, const u8 *data);
+void patch_packGlobals(u8 *data);
+void patch_unpackGlobals(const u8 *data);
+bool patch_loadPreset(const u8 *bank, u16 number);
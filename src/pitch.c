@@ -0,0 +1,151 @@
+#include <genesis.h>
+#include <pitch.h>
+
+/* F-numbers for B to A# within a block */
+static const u16 NOTE_FREQUENCIES[NOTE_COUNT] = {617, 653, 692, 733, 777,  823,
+                                                 872, 924, 979, 1037, 1099, 1164};
+
+/* F-numbers in 1/16 semitone steps from B, matching NOTE_FREQUENCIES on each note */
+static const u16 FINE_FREQUENCIES[PITCH_STEPS_PER_OCTAVE] = {
+    617, 619, 621, 624, 626, 628, 630, 632, 635, 637, 639, 642,
+    644, 646, 648, 651, 653, 655, 658, 660, 663, 665, 667, 670,
+    672, 675, 677, 680, 682, 685, 687, 689, 692, 694, 697, 700,
+    702, 705, 707, 710, 712, 715, 717, 720, 723, 725, 728, 730,
+    733, 736, 738, 741, 744, 746, 749, 752, 755, 757, 760, 763,
+    766, 769, 771, 774, 777, 780, 783, 785, 788, 791, 794, 797,
+    800, 803, 805, 808, 811, 814, 817, 820, 823, 826, 829, 832,
+    835, 838, 841, 844, 847, 850, 853, 856, 859, 863, 866, 869,
+    872, 875, 878, 882, 885, 888, 891, 894, 898, 901, 904, 907,
+    911, 914, 917, 921, 924, 927, 931, 934, 937, 941, 944, 948,
+    951, 955, 958, 961, 965, 968, 972, 975, 979, 983, 986, 990,
+    993, 997, 1000, 1004, 1008, 1011, 1015, 1019, 1022, 1026, 1030, 1033,
+    1037, 1041, 1045, 1048, 1052, 1056, 1060, 1064, 1068, 1071, 1075, 1079,
+    1083, 1087, 1091, 1095, 1099, 1103, 1107, 1111, 1115, 1119, 1123, 1127,
+    1131, 1135, 1139, 1143, 1147, 1152, 1156, 1160, 1164, 1168, 1173, 1177,
+    1181, 1185, 1190, 1194, 1198, 1203, 1207, 1212, 1216, 1221, 1225, 1230};
+
+u16 pitch_noteFrequency(u8 note) { return NOTE_FREQUENCIES[note]; }
+
+u16 pitch_fineFrequency(u8 step) { return FINE_FREQUENCIES[step]; }
+
+/*
+ * Finds the highest fine step at or below an F-number, first moving it into
+ * the table's range by adjusting the block.
+ */
+u8 pitch_fineStep(u16 freq, u8 *octave)
+{
+    if (freq == 0)
+    {
+        return 0;
+    }
+    while (freq < FINE_FREQUENCIES[0] && *octave > 0)
+    {
+        freq <<= 1;
+        (*octave)--;
+    }
+    while (freq >= FINE_FREQUENCIES[0] << 1 && *octave < MAX_OCTAVE)
+    {
+        freq >>= 1;
+        (*octave)++;
+    }
+    u8 low = 0;
+    u8 high = PITCH_STEPS_PER_OCTAVE - 1;
+    while (low < high)
+    {
+        u8 mid = (low + high + 1) >> 1;
+        if (FINE_FREQUENCIES[mid] <= freq)
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid - 1;
+        }
+    }
+    return low;
+}
+
+void pitch_transpose(u8 *note, u8 *octave, s8 semitones)
+{
+    s16 n = *note + semitones;
+    s16 o = *octave;
+    while (n >= NOTE_COUNT)
+    {
+        n -= NOTE_COUNT;
+        o++;
+    }
+    while (n < 0)
+    {
+        n += NOTE_COUNT;
+        o--;
+    }
+    if (o < 0)
+    {
+        o = 0;
+    }
+    if (o > MAX_OCTAVE)
+    {
+        o = MAX_OCTAVE;
+    }
+    *note = n;
+    *octave = o;
+}
+
+/* MIDI note 59 (B3) is the first note of block 4 */
+void pitch_fromMidi(u8 midiNote, u8 *note, u8 *octave)
+{
+    s16 n = midiNote + 1;
+    s16 o = -1;
+    while (n >= NOTE_COUNT)
+    {
+        n -= NOTE_COUNT;
+        o++;
+    }
+    if (o < 0)
+    {
+        o = 0;
+    }
+    if (o > MAX_OCTAVE)
+    {
+        o = MAX_OCTAVE;
+    }
+    *note = n;
+    *octave = o;
+}
+
+/*
+ * Interpolates the F-number linearly towards the note two semitones away,
+ * with bend in -8192..8191. The block is raised if the result no longer fits
+ * in 11 bits.
+ */
+u16 pitch_bentFrequency(u8 note, u8 *octave, s16 bend)
+{
+    u8 targetNote = note;
+    u8 targetOctave = *octave;
+    pitch_transpose(&targetNote, &targetOctave, bend < 0 ? -2 : 2);
+    s16 from = NOTE_FREQUENCIES[note];
+    s16 to = NOTE_FREQUENCIES[targetNote];
+    if (targetOctave > *octave)
+    {
+        to <<= 1;
+    }
+    else if (targetOctave < *octave)
+    {
+        to >>= 1;
+    }
+    u16 amount = bend < 0 ? -bend : bend;
+    s32 freq = from + (((s32)(to - from) * amount) >> 13);
+    if (freq > 0x7FF)
+    {
+        if (*octave < MAX_OCTAVE)
+        {
+            freq >>= 1;
+            (*octave)++;
+        }
+        else
+        {
+            freq = 0x7FF;
+        }
+    }
+    return freq;
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <genesis.h>
+
+#define NOTE_COUNT 12
+#define MAX_OCTAVE 7
+#define PITCH_STEPS_PER_NOTE 16
+#define PITCH_STEPS_PER_OCTAVE (NOTE_COUNT * PITCH_STEPS_PER_NOTE)
+
+u16 pitch_noteFrequency(u8 note);
+void pitch_transpose(u8 *note, u8 *octave, s8 semitones);
+void pitch_fromMidi(u8 midiNote, u8 *note, u8 *octave);
+u16 pitch_bentFrequency(u8 note, u8 *octave, s16 bend);
+u16 pitch_fineFrequency(u8 step);
+u8 pitch_fineStep(u16 freq, u8 *octave);
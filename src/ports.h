@@ -0,0 +1,12 @@
+#pragma once
+#include <genesis.h>
+
+/*
+ * Raw reads and writes of the hardware ports SGDK has no call for. They are
+ * macros so they cost no more than the pointer accesses they stand for; the
+ * host build has its own ports.h that routes them to a model of the hardware.
+ */
+#define PORT_READ_U8(address) (*(vu8 *)(address))
+#define PORT_WRITE_U8(address, value) (*(vu8 *)(address) = (value))
+#define PORT_WRITE_U16(address, value) (*(vu16 *)(address) = (value))
+#define PORT_WRITE_U32(address, value) (*(vu32 *)(address) = (value))
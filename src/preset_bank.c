@@ -0,0 +1,18 @@
+/* Generated by tools/lzpack; do not edit. */
+#include <genesis.h>
+
+const u8 PRESET_BANK[154] = {
+    0x00, 0x00, 0x00, 0xC1, 0xFF, 0xC0, 0x05, 0xFD, 0x20, 0x2E, 0x03, 0x14,
+    0x24, 0xFF, 0x81, 0x08, 0xA0, 0x00, 0x08, 0x90, 0x92, 0x04, 0xFF, 0x22,
+    0x80, 0x00, 0x03, 0x28, 0x48, 0x10, 0x8A, 0xFF, 0x80, 0x00, 0xC0, 0x81,
+    0x20, 0x42, 0x2A, 0x00, 0xFF, 0x00, 0x07, 0x7E, 0x97, 0x36, 0x00, 0x04,
+    0x35, 0xFF, 0x22, 0x00, 0x80, 0x00, 0x00, 0x0F, 0xA6, 0x98, 0xFF, 0x00,
+    0x00, 0x00, 0x03, 0x4B, 0x0A, 0x10, 0x08, 0xEE, 0x07, 0x00, 0x8A, 0xA8,
+    0x40, 0x05, 0x00, 0x05, 0xFD, 0x38, 0xFF, 0x06, 0x00, 0x04, 0x6E, 0x45,
+    0x10, 0x8D, 0x73, 0xFF, 0x80, 0x11, 0xB9, 0x14, 0x42, 0x35, 0x84, 0x80,
+    0xFF, 0x46, 0xE4, 0x51, 0x08, 0xD8, 0x96, 0x01, 0x1B, 0xFF, 0x91, 0x44,
+    0x23, 0x17, 0xF0, 0x05, 0xFD, 0x00, 0xFF, 0x06, 0x01, 0x14, 0x68, 0xA5,
+    0x10, 0x88, 0x00, 0xFF, 0x03, 0x56, 0xD9, 0x00, 0x42, 0x20, 0x00, 0x33,
+    0xFF, 0x4C, 0xFC, 0x51, 0x08, 0x80, 0x00, 0x04, 0x05, 0x27, 0x91, 0xC5,
+    0x4C, 0x3F, 0x01, 0x1F, 0x0B, 0x00, 0x1F, 0x1C, 0x3F, 0x0D,
+};
@@ -0,0 +1,12 @@
+#pragma once
+#include <genesis.h>
+
+/*
+ * The presets in presets.h in the patch format, packed with tools/lzpack for
+ * patch_loadPreset. preset_bank.c is generated; run make bank after editing
+ * presets.h.
+ */
+#define PRESET_BANK_COUNT 1
+#define PRESET_CASTLEVANIA_NUMBER 0
+
+extern const u8 PRESET_BANK[];
@@ -1,6 +1,8 @@
 #pragma once
 #include <synth.h>
 
+/* The source of the preset bank in preset_bank.h, packed by make bank */
+
 const struct Preset PRESET_CASTLEVANIA =
     {.globalParameters = {1, 4},
      .channels = {{.channelParameters = {0, 0x02FE, 4, 4, 0, 0, 5, 3},
@@ -16,10 +18,10 @@ const struct Preset PRESET_CASTLEVANIA =
                         {0x00, 0x03, 0x25, 0x02, 0x02, 1, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00},
                         {0x00, 0x00, 0x11, 0x01, 0x0A, 1, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00}}},
                   {.channelParameters = {0, 0x02FE, 4, 7, 0, 0, 0, 3},
-                   .operatorParameters = {{0, 0, 35, 1, 25, 0, 5, 2, 1, 1, 5, 653},
+                   .operatorParameters = {{0, 0, 35, 1, 25, 0, 5, 2, 1, 1, 5, 924},
                                           {0, 0, 35, 1, 25, 0, 5, 2, 1, 1, 5, 777},
-                                          {0, 0, 35, 1, 25, 0, 5, 2, 1, 1, 5, 924},
-                                          {0, 0, 35, 1, 25, 0, 5, 2, 1, 1, 5, 1099}}},
+                                          {0, 0, 35, 1, 25, 0, 5, 2, 1, 1, 5, 1099},
+                                          {0, 0, 35, 1, 25, 0, 5, 2, 1, 1, 4, 0x02FE}}},
                   {.channelParameters = {0, 0x02FE, 4, 0, 0, 0, 0, 3},
                    .operatorParameters = {{1, 1, 35, 1, 2, 1, 5, 2, 1, 1, 0x00, 0x00},
                                           {0, 13, 45, 2, 25, 0, 36, 2, 1, 1, 0x00, 0x00},
@@ -0,0 +1,194 @@
+#include <genesis.h>
+#include <profiler.h>
+
+#define WINDOW_FRAMES_SHIFT 5
+#define WINDOW_FRAMES (1 << WINDOW_FRAMES_SHIFT)
+#define NTSC_FRAME_LINES 262
+#define PAL_FRAME_LINES 313
+#define VINT_LINE 0xE0
+#define NTSC_V_REPEAT_FIRST 0xE5
+#define NTSC_V_REPEAT_LAST 0xEA
+#define NTSC_V_JUMP 6
+#define PAL_V_WRAP_LAST 0x02
+#define PAL_V_WRAP 256
+#define PAL_V_REPEAT_FIRST 0xCA
+#define PAL_V_JUMP 57
+#define H_LAST_BEFORE_JUMP 0xB6
+#define H_JUMP (0xE4 - 0xB7)
+#define H_STEPS 210
+#define H_LINE_START 0xA5
+
+/*
+ * Timestamps count 1/256ths of a scanline. The VBlank interrupt advances a
+ * base by a frame's worth, and a timestamp adds the line since VBlank from
+ * the VDP's V counter and the part of the line from the H counter, read
+ * together. The H counter skips values in the blanking area (H40 jumps from
+ * B6 to E4), so it is made linear first; the V counter steps at H A5, which
+ * is where a line starts. The V counter also jumps back in the blanking
+ * area (NTSC repeats E5-EA; PAL in 224 line mode wraps after FF, counts
+ * 00-02 and repeats CA-FF), so a repeated value is resolved to the earliest
+ * line not before the previous timestamp. A timestamp earlier than the
+ * previous one means VBlank is pending with interrupts disabled, so it
+ * belongs to the next frame. Timestamps are only taken from the main loop.
+ * Sections are accumulated per frame, may span frames, and are summarised
+ * in whole lines, rounded up, over a window of frames. Sections must not
+ * nest.
+ */
+typedef struct
+{
+    u32 start;
+    u32 frameTotal;
+    u32 windowTotal;
+    u32 windowMin;
+    u32 windowMax;
+} Section;
+
+static Section sections[PROFILER_SECTION_COUNT];
+static ProfilerStats stats[PROFILER_SECTION_COUNT];
+static u16 windowFrame = 0;
+static bool newStats = false;
+static bool pal;
+static u16 frameLines = NTSC_FRAME_LINES;
+static volatile u32 vblankTime = 0;
+static u32 lastTimestamp = 0;
+
+static void resetWindow(Section *section);
+static u16 toLines(u32 ticks);
+static u32 sinceVBlank(u16 line);
+static u16 lineFraction(u8 h);
+
+void profiler_init(void)
+{
+    pal = SYS_isPAL();
+    frameLines = pal ? PAL_FRAME_LINES : NTSC_FRAME_LINES;
+}
+
+void profiler_vblank(void) { vblankTime += (u32)frameLines << PROFILER_LINE_SHIFT; }
+
+u32 profiler_vblankTime(void) { return vblankTime; }
+
+void profiler_begin(ProfilerSection section) { sections[section].start = profiler_timestamp(); }
+
+void profiler_end(ProfilerSection section)
+{
+    Section *s = &sections[section];
+    s->frameTotal += profiler_timestamp() - s->start;
+}
+
+u32 profiler_timestamp(void)
+{
+    u32 base;
+    u16 hv;
+    do
+    {
+        base = vblankTime;
+        hv = GET_HVCOUNTER;
+    } while (base != vblankTime);
+    u8 v = hv >> 8;
+    u16 line = v;
+    u16 repeatLine = v;
+    if (pal)
+    {
+        if (v <= PAL_V_WRAP_LAST)
+        {
+            repeatLine = v + PAL_V_WRAP;
+        }
+        else if (v >= PAL_V_REPEAT_FIRST)
+        {
+            repeatLine = v + PAL_V_JUMP;
+        }
+    }
+    else if (v > NTSC_V_REPEAT_LAST)
+    {
+        line = v + NTSC_V_JUMP;
+        repeatLine = line;
+    }
+    else if (v >= NTSC_V_REPEAT_FIRST)
+    {
+        repeatLine = v + NTSC_V_JUMP;
+    }
+    base += lineFraction(hv & 0xFF);
+    u32 earlier = base + sinceVBlank(line);
+    u32 later = base + sinceVBlank(repeatLine);
+    if ((s32)(later - earlier) < 0)
+    {
+        u32 swap = later;
+        later = earlier;
+        earlier = swap;
+    }
+    u32 timestamp = (s32)(earlier - lastTimestamp) >= 0 ? earlier
+                    : (s32)(later - lastTimestamp) >= 0
+                        ? later
+                        : earlier + ((u32)frameLines << PROFILER_LINE_SHIFT);
+    lastTimestamp = timestamp;
+    return timestamp;
+}
+
+void profiler_endFrame(void)
+{
+    bool windowComplete = ++windowFrame == WINDOW_FRAMES;
+    for (u16 i = 0; i < PROFILER_SECTION_COUNT; i++)
+    {
+        Section *s = &sections[i];
+        if (windowFrame == 1 || s->frameTotal < s->windowMin)
+        {
+            s->windowMin = s->frameTotal;
+        }
+        if (s->frameTotal > s->windowMax)
+        {
+            s->windowMax = s->frameTotal;
+        }
+        s->windowTotal += s->frameTotal;
+        s->frameTotal = 0;
+        if (windowComplete)
+        {
+            stats[i].min = toLines(s->windowMin);
+            stats[i].avg = toLines(s->windowTotal >> WINDOW_FRAMES_SHIFT);
+            stats[i].max = toLines(s->windowMax);
+            resetWindow(s);
+        }
+    }
+    if (windowComplete)
+    {
+        windowFrame = 0;
+        newStats = true;
+    }
+}
+
+bool profiler_hasNewStats(void)
+{
+    bool result = newStats;
+    newStats = false;
+    return result;
+}
+
+const ProfilerStats *profiler_stats(ProfilerSection section) { return &stats[section]; }
+
+u16 profiler_frameLines(void) { return frameLines; }
+
+static void resetWindow(Section *section)
+{
+    section->windowTotal = 0;
+    section->windowMin = 0;
+    section->windowMax = 0;
+}
+
+static u16 toLines(u32 ticks)
+{
+    u32 lines = (ticks + (1 << PROFILER_LINE_SHIFT) - 1) >> PROFILER_LINE_SHIFT;
+    return lines > 0xFFFF ? 0xFFFF : lines;
+}
+
+static u32 sinceVBlank(u16 line)
+{
+    return (u32)(line >= VINT_LINE ? line - VINT_LINE : line + frameLines - VINT_LINE)
+           << PROFILER_LINE_SHIFT;
+}
+
+/* 256/210ths of the steps since the line started, as 1 + 1/4 - 1/32 */
+static u16 lineFraction(u8 h)
+{
+    u16 step = h > H_LAST_BEFORE_JUMP ? h - H_JUMP : h;
+    step = step >= H_LINE_START ? step - H_LINE_START : step + H_STEPS - H_LINE_START;
+    return step + (step >> 2) - (step >> 5);
+}
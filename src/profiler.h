@@ -0,0 +1,31 @@
+#pragma once
+#include <genesis.h>
+
+#define PROFILER_SECTION_COUNT 5
+#define PROFILER_LINE_SHIFT 8
+
+typedef enum {
+    PROFILER_INPUT,
+    PROFILER_DISPLAY,
+    PROFILER_YM2612,
+    PROFILER_AUDIO,
+    PROFILER_ENVELOPE
+} ProfilerSection;
+
+typedef struct
+{
+    u16 min;
+    u16 avg;
+    u16 max;
+} ProfilerStats;
+
+void profiler_init(void);
+void profiler_vblank(void);
+u32 profiler_vblankTime(void);
+void profiler_begin(ProfilerSection section);
+void profiler_end(ProfilerSection section);
+void profiler_endFrame(void);
+bool profiler_hasNewStats(void);
+const ProfilerStats *profiler_stats(ProfilerSection section);
+u16 profiler_frameLines(void);
+u32 profiler_timestamp(void);
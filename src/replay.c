@@ -0,0 +1,183 @@
+#include <arpeggiator.h>
+#include <automation.h>
+#include <ch3voice.h>
+#include <genesis.h>
+#include <link.h>
+#include <megadrive.h>
+#include <patch.h>
+#include <replay.h>
+#include <scheduler.h>
+#include <synth.h>
+
+#define MAX_RUNS 512
+
+/*
+ * Joypad input is recorded per frame as runs of identical states, along with
+ * a snapshot of the synth at the start of recording: patches, arpeggiator
+ * settings and link groups. Playing back restores the snapshot and feeds the
+ * runs back in, while every YM2612 write is folded into a count and a
+ * Fletcher-style signature that can be compared between runs; the trace of
+ * the recording is kept when playback starts. Whatever the snapshot does not
+ * hold is settled the same way at both ends: notes off at full velocity with
+ * glides finished, and the arpeggiator, channel 3 voices and automation
+ * stopped. Automation is stopped before the snapshot is restored, as stopping
+ * it puts parameters back. The scheduler clock is restarted before anything
+ * else, so its ticks fall at the same point in the frame both times.
+ */
+typedef struct
+{
+    u16 joyState;
+    u16 frames;
+} Run;
+
+static ReplayState state = REPLAY_IDLE;
+static Run runs[MAX_RUNS];
+static u16 runCount = 0;
+static u16 runIndex;
+static u16 runFrame;
+static u8 globalsSnapshot[PATCH_GLOBALS_SIZE];
+static u8 channelSnapshots[CHANNEL_COUNT][PATCH_CHANNEL_SIZE];
+static u8 arpSnapshot[ARP_SNAPSHOT_SIZE];
+static u8 linkSnapshot[LINK_SNAPSHOT_SIZE];
+static u16 writeCount;
+static u16 recordedWriteCount;
+static u16 recordedSignature;
+static u8 sum1;
+static u8 sum2;
+
+static void settle(void);
+static void resetTrace(void);
+static void traceByte(u8 data);
+
+void replay_record(void)
+{
+    scheduler_restartClock();
+    settle();
+    patch_packGlobals(globalsSnapshot);
+    for (u8 c = 0; c < CHANNEL_COUNT; c++)
+    {
+        patch_packChannel(synth_channel(c), channelSnapshots[c]);
+    }
+    arpeggiator_snapshot(arpSnapshot);
+    link_snapshot(linkSnapshot);
+    runCount = 0;
+    resetTrace();
+    state = REPLAY_RECORDING;
+}
+
+void replay_play(void)
+{
+    if (state == REPLAY_RECORDING)
+    {
+        recordedWriteCount = writeCount;
+        recordedSignature = replay_signature();
+    }
+    state = REPLAY_IDLE;
+    scheduler_restartClock();
+    arpeggiator_stop();
+    automation_stop();
+    patch_unpackGlobals(globalsSnapshot);
+    for (u8 c = 0; c < CHANNEL_COUNT; c++)
+    {
+        patch_unpackChannel(synth_channel(c), channelSnapshots[c]);
+    }
+    arpeggiator_restore(arpSnapshot);
+    link_restore(linkSnapshot);
+    settle();
+    runIndex = 0;
+    runFrame = 0;
+    resetTrace();
+    state = REPLAY_PLAYING;
+}
+
+void replay_stop(void) { state = REPLAY_IDLE; }
+
+ReplayState replay_state(void) { return state; }
+
+u16 replay_joypad(u16 joyState)
+{
+    if (state == REPLAY_RECORDING)
+    {
+        Run *run = runCount > 0 ? &runs[runCount - 1] : NULL;
+        if (run != NULL && run->joyState == joyState && run->frames != 0xFFFF)
+        {
+            run->frames++;
+        }
+        else if (runCount < MAX_RUNS)
+        {
+            runs[runCount].joyState = joyState;
+            runs[runCount].frames = 1;
+            runCount++;
+        }
+        else
+        {
+            state = REPLAY_IDLE;
+        }
+        return joyState;
+    }
+    if (state == REPLAY_PLAYING)
+    {
+        if (runIndex == runCount)
+        {
+            state = REPLAY_IDLE;
+            return 0;
+        }
+        u16 replayed = runs[runIndex].joyState;
+        if (++runFrame == runs[runIndex].frames)
+        {
+            runFrame = 0;
+            runIndex++;
+        }
+        return replayed;
+    }
+    return joyState;
+}
+
+void replay_traceWrite(u8 part, u8 reg, u8 data)
+{
+    if (state == REPLAY_IDLE)
+    {
+        return;
+    }
+    writeCount++;
+    traceByte(part);
+    traceByte(reg);
+    traceByte(data);
+}
+
+u16 replay_writeCount(void) { return writeCount; }
+
+u16 replay_signature(void) { return (sum2 << 8) | sum1; }
+
+u16 replay_recordedWriteCount(void) { return recordedWriteCount; }
+
+u16 replay_recordedSignature(void) { return recordedSignature; }
+
+static void settle(void)
+{
+    arpeggiator_stop();
+    ch3voice_allOff();
+    automation_stop();
+    for (u8 c = 0; c < CHANNEL_COUNT; c++)
+    {
+        Channel *chan = synth_channel(c);
+        channel_keyOff(chan);
+        channel_setVelocity(chan, FULL_VELOCITY);
+        channel_setFrequency(chan, channel_parameterValue(chan, PARAMETER_FREQ),
+                             channel_parameterValue(chan, PARAMETER_OCTAVE));
+    }
+    megadrive_drainWrites();
+}
+
+static void resetTrace(void)
+{
+    writeCount = 0;
+    sum1 = 0;
+    sum2 = 0;
+}
+
+static void traceByte(u8 data)
+{
+    sum1 += data;
+    sum2 += sum1;
+}
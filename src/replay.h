@@ -0,0 +1,15 @@
+#pragma once
+#include <genesis.h>
+
+typedef enum { REPLAY_IDLE, REPLAY_RECORDING, REPLAY_PLAYING } ReplayState;
+
+void replay_record(void);
+void replay_play(void);
+void replay_stop(void);
+ReplayState replay_state(void);
+u16 replay_joypad(u16 joyState);
+void replay_traceWrite(u8 part, u8 reg, u8 data);
+u16 replay_writeCount(void);
+u16 replay_signature(void);
+u16 replay_recordedWriteCount(void);
+u16 replay_recordedSignature(void);
@@ -0,0 +1,111 @@
+#include <genesis.h>
+#include <profiler.h>
+#include <scheduler.h>
+
+#define TIMER_A_STEPS 1024
+#define MASTER_CLOCKS_PER_TIMER_A_STEP (7 * 144)
+#define MASTER_CLOCKS_PER_LINE 3420
+
+/*
+ * Events are timed in YM2612 Timer A periods rather than frames, so they run
+ * at the same tempo on PAL and NTSC. The 68000 has no YM2612 interrupt and
+ * the horizontal interrupt does not fire during VBlank, which on PAL is longer
+ * than a Timer A period, so polling the overflow flag would lose ticks.
+ * Instead the periods are counted on the profiler's scanline clock: Timer A
+ * steps every 144 YM2612 cycles (1008 master clocks) and a line is 3420
+ * master clocks on both regions, so the count matches the hardware timer
+ * without touching the YM2612. Due events are dispatched from the main loop
+ * by scheduler_poll, a frame late at most, so callbacks never run at
+ * interrupt level.
+ */
+typedef struct
+{
+    u16 due;
+    SchedulerCallback callback;
+    u16 param;
+} Event;
+
+static Event events[SCHEDULER_EVENT_COUNT];
+static u16 ticks = 0;
+static u32 tickLength;
+static u32 lastPoll;
+static u32 sinceTick;
+
+static void dispatchDueEvents(void);
+
+void scheduler_init(void)
+{
+    scheduler_setTickRate(SCHEDULER_TICK_TIMER_A);
+    lastPoll = profiler_timestamp();
+}
+
+/* Takes a Timer A load value and converts its period to profiler time */
+void scheduler_setTickRate(u16 timerA)
+{
+    tickLength = (((u32)(TIMER_A_STEPS - timerA) * MASTER_CLOCKS_PER_TIMER_A_STEP)
+                     << PROFILER_LINE_SHIFT)
+        / MASTER_CLOCKS_PER_LINE;
+}
+
+void scheduler_poll(void)
+{
+    u32 now = profiler_timestamp();
+    sinceTick += now - lastPoll;
+    lastPoll = now;
+    profiler_begin(PROFILER_AUDIO);
+    while (sinceTick >= tickLength)
+    {
+        sinceTick -= tickLength;
+        ticks++;
+        dispatchDueEvents();
+    }
+    profiler_end(PROFILER_AUDIO);
+}
+
+/*
+ * Drops every pending event and starts a fresh Timer A period, so ticks fall
+ * at the same point relative to the caller each time.
+ */
+void scheduler_restartClock(void)
+{
+    for (u16 i = 0; i < SCHEDULER_EVENT_COUNT; i++)
+    {
+        events[i].callback = NULL;
+    }
+    lastPoll = profiler_timestamp();
+    sinceTick = 0;
+}
+
+bool scheduler_schedule(u16 delayTicks, SchedulerCallback callback, u16 param)
+{
+    bool scheduled = false;
+    for (u16 i = 0; i < SCHEDULER_EVENT_COUNT; i++)
+    {
+        Event *event = &events[i];
+        if (event->callback == NULL)
+        {
+            event->due = ticks + delayTicks;
+            event->callback = callback;
+            event->param = param;
+            scheduled = true;
+            break;
+        }
+    }
+    return scheduled;
+}
+
+u16 scheduler_ticks(void) { return ticks; }
+
+static void dispatchDueEvents(void)
+{
+    for (u16 i = 0; i < SCHEDULER_EVENT_COUNT; i++)
+    {
+        Event *event = &events[i];
+        if (event->callback != NULL && (s16)(ticks - event->due) >= 0)
+        {
+            SchedulerCallback callback = event->callback;
+            event->callback = NULL;
+            callback(event->param);
+        }
+    }
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <genesis.h>
+#include <stdbool.h>
+
+#define SCHEDULER_EVENT_COUNT 16
+#define SCHEDULER_TICK_TIMER_A 811
+
+typedef void (*SchedulerCallback)(u16 param);
+
+void scheduler_init(void);
+void scheduler_setTickRate(u16 timerA);
+void scheduler_poll(void);
+void scheduler_restartClock(void);
+bool scheduler_schedule(u16 delayTicks, SchedulerCallback callback, u16 param);
+u16 scheduler_ticks(void);
@@ -0,0 +1,168 @@
+#include <channel.h>
+#include <genesis.h>
+#include <megadrive.h>
+#include <patch.h>
+#include <storage.h>
+#include <synth.h>
+
+#define STORAGE_MAGIC_0 'Y'
+#define STORAGE_MAGIC_1 'M'
+#define STORAGE_VERSION 3
+#define HEADER_SIZE 3
+#define CRC_SIZE 2
+#define BLOCK_DATA_SIZE PATCH_CHANNEL_SIZE
+#define BLOCK_SIZE (BLOCK_DATA_SIZE + CRC_SIZE)
+#define GLOBALS_BLOCK 0
+#define BLOCK_COUNT (CHANNEL_COUNT + 1)
+#define ALL_BLOCKS ((1 << BLOCK_COUNT) - 1)
+#define NO_BLOCK 0xFF
+#define BYTES_PER_FRAME 8
+
+/*
+ * SRAM holds a header followed by one block for the globals and one per
+ * channel, each with its own CRC. Edits mark blocks dirty and dirty blocks
+ * are written back a few bytes per frame, CRC last, so a save never stalls
+ * a frame and an interrupted write only invalidates the block it was in.
+ */
+static u8 dirtyBlocks = 0;
+static u8 writingBlock = NO_BLOCK;
+static u8 writePosition;
+static u8 blockBuffer[BLOCK_SIZE];
+
+static bool validHeader(void);
+static void writeHeader(void);
+static bool loadBlock(u8 block);
+static void packBlock(u8 block, u8 *data);
+static u32 blockOffset(u8 block);
+static u16 crc16(const u8 *data, u16 length);
+
+bool storage_load(void)
+{
+    SRAM_enableRO();
+    if (!validHeader())
+    {
+        SRAM_disable();
+        SRAM_enable();
+        writeHeader();
+        SRAM_disable();
+        dirtyBlocks = ALL_BLOCKS;
+        return false;
+    }
+    bool loaded = true;
+    megadrive_beginBulkWrites();
+    for (u8 block = 0; block < BLOCK_COUNT; block++)
+    {
+        if (!loadBlock(block))
+        {
+            dirtyBlocks |= 1 << block;
+            loaded = false;
+        }
+    }
+    megadrive_endBulkWrites();
+    SRAM_disable();
+    return loaded;
+}
+
+void storage_markChannelDirty(Channel *chan) { dirtyBlocks |= 1 << (chan->number + 1); }
+
+void storage_markGlobalsDirty(void) { dirtyBlocks |= 1 << GLOBALS_BLOCK; }
+
+void storage_update(void)
+{
+    if (writingBlock == NO_BLOCK)
+    {
+        if (dirtyBlocks == 0)
+        {
+            return;
+        }
+        writingBlock = 0;
+        while (!(dirtyBlocks & (1 << writingBlock)))
+        {
+            writingBlock++;
+        }
+        dirtyBlocks &= ~(1 << writingBlock);
+        packBlock(writingBlock, blockBuffer);
+        u16 crc = crc16(blockBuffer, BLOCK_DATA_SIZE);
+        blockBuffer[BLOCK_DATA_SIZE] = crc >> 8;
+        blockBuffer[BLOCK_DATA_SIZE + 1] = crc;
+        writePosition = 0;
+    }
+
+    u32 offset = blockOffset(writingBlock);
+    SRAM_enable();
+    for (u8 i = 0; i < BYTES_PER_FRAME && writePosition < BLOCK_SIZE; i++)
+    {
+        SRAM_writeByte(offset + writePosition, blockBuffer[writePosition]);
+        writePosition++;
+    }
+    SRAM_disable();
+    if (writePosition == BLOCK_SIZE)
+    {
+        writingBlock = NO_BLOCK;
+    }
+}
+
+static bool validHeader(void)
+{
+    return SRAM_readByte(0) == STORAGE_MAGIC_0 && SRAM_readByte(1) == STORAGE_MAGIC_1 &&
+           SRAM_readByte(2) == STORAGE_VERSION;
+}
+
+static void writeHeader(void)
+{
+    SRAM_writeByte(0, STORAGE_MAGIC_0);
+    SRAM_writeByte(1, STORAGE_MAGIC_1);
+    SRAM_writeByte(2, STORAGE_VERSION);
+}
+
+static bool loadBlock(u8 block)
+{
+    u32 offset = blockOffset(block);
+    for (u8 i = 0; i < BLOCK_SIZE; i++)
+    {
+        blockBuffer[i] = SRAM_readByte(offset + i);
+    }
+    u16 crc = (blockBuffer[BLOCK_DATA_SIZE] << 8) | blockBuffer[BLOCK_DATA_SIZE + 1];
+    if (crc != crc16(blockBuffer, BLOCK_DATA_SIZE))
+    {
+        return false;
+    }
+    if (block == GLOBALS_BLOCK)
+    {
+        patch_unpackGlobals(blockBuffer);
+    }
+    else
+    {
+        patch_unpackChannel(synth_channel(block - 1), blockBuffer);
+    }
+    return true;
+}
+
+static void packBlock(u8 block, u8 *data)
+{
+    memset(data, 0, BLOCK_DATA_SIZE);
+    if (block == GLOBALS_BLOCK)
+    {
+        patch_packGlobals(data);
+    }
+    else
+    {
+        patch_packChannel(synth_channel(block - 1), data);
+    }
+}
+
+static u32 blockOffset(u8 block) { return HEADER_SIZE + (u32)block * BLOCK_SIZE; }
+
+static u16 crc16(const u8 *data, u16 length)
+{
+    u16 crc = 0xFFFF;
+    while (length--)
+    {
+        crc ^= *data++ << 8;
+        for (u8 bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include <channel.h>
+#include <genesis.h>
+#include <stdbool.h>
+
+bool storage_load(void);
+void storage_markChannelDirty(Channel *chan);
+void storage_markGlobalsDirty(void);
+void storage_update(void);
@@ -1,17 +1,22 @@
 #include <channel.h>
 #include <genesis.h>
+#include <megadrive.h>
 #include <operator.h>
 #include <synth.h>
 
+#define CH3_SPECIAL_MODE (1 << 6)
+
 static void updateGlobalLFO(Channel *chan);
 static void setGlobalLFO(u8 enable, u8 freq);
 
 static Channel channels[6];
+static u8 channel3Mode = CH3_SPECIAL_MODE;
 
 static FmParameter globalParameters[] = {{1, 1, updateGlobalLFO}, {3, 7, updateGlobalLFO}};
 
-static void loadChannelPreset(ChannelPreset *chanPreset, Channel *chan);
-static void loadOperatorPreset(Operator *op, u16 operatorParameters[OPERATOR_PARAMETER_COUNT]);
+static void loadChannelPreset(const ChannelPreset *chanPreset, Channel *chan);
+static void loadOperatorPreset(Operator *op,
+                               const u16 operatorParameters[OPERATOR_PARAMETER_COUNT]);
 
 void synth_init(void)
 {
@@ -21,17 +26,17 @@ void synth_init(void)
         channel_init(&channels[i], i);
     }
     updateGlobalLFO(NULL);
-    YM2612_writeReg(0, 0x27, 1 << 6); // Ch 3 Special Mode
-    YM2612_writeReg(0, 0x28, 0);      // All channels off
-    YM2612_writeReg(0, 0x28, 1);
-    YM2612_writeReg(0, 0x28, 2);
-    YM2612_writeReg(0, 0x28, 4);
-    YM2612_writeReg(0, 0x28, 5);
-    YM2612_writeReg(0, 0x28, 6);
-    YM2612_writeReg(0, 0x90, 0); // Proprietary
-    YM2612_writeReg(0, 0x94, 0);
-    YM2612_writeReg(0, 0x98, 0);
-    YM2612_writeReg(0, 0x9C, 0);
+    synth_setTimerControl(0);                // Ch 3 Special Mode
+    megadrive_writeToYm2612Part(0, 0x28, 0); // All channels off
+    megadrive_writeToYm2612Part(0, 0x28, 1);
+    megadrive_writeToYm2612Part(0, 0x28, 2);
+    megadrive_writeToYm2612Part(0, 0x28, 4);
+    megadrive_writeToYm2612Part(0, 0x28, 5);
+    megadrive_writeToYm2612Part(0, 0x28, 6);
+    megadrive_writeToYm2612Part(0, 0x90, 0); // Proprietary
+    megadrive_writeToYm2612Part(0, 0x94, 0);
+    megadrive_writeToYm2612Part(0, 0x98, 0);
+    megadrive_writeToYm2612Part(0, 0x9C, 0);
 }
 
 Channel *synth_channel(u8 number) { return &channels[number]; }
@@ -61,21 +66,28 @@ u16 synth_globalParameterValue(GlobalParameters parameter)
     return globalParameters[parameter].value;
 }
 
+u16 synth_globalParameterMaxValue(GlobalParameters parameter)
+{
+    return globalParameters[parameter].maxValue;
+}
+
 void synth_preset(const Preset *preset)
 {
+    megadrive_beginBulkWrites();
     for (u16 p = 0; p < GLOBAL_PARAMETER_COUNT; p++)
     {
         synth_setGlobalParameterValue(p, preset->globalParameters[p]);
     }
     for (u16 c = 0; c < CHANNEL_COUNT; c++)
     {
-        ChannelPreset *chanPreset = &preset->channels[c];
+        const ChannelPreset *chanPreset = &preset->channels[c];
         Channel *chan = &channels[c];
         loadChannelPreset(chanPreset, chan);
     }
+    megadrive_endBulkWrites();
 }
 
-static void loadChannelPreset(ChannelPreset *chanPreset, Channel *chan)
+static void loadChannelPreset(const ChannelPreset *chanPreset, Channel *chan)
 {
     for (u16 p = 0; p < FM_PARAMETER_COUNT; p++)
     {
@@ -88,7 +100,8 @@ static void loadChannelPreset(ChannelPreset *chanPreset, Channel *chan)
     }
 }
 
-static void loadOperatorPreset(Operator *op, u16 operatorParameters[OPERATOR_PARAMETER_COUNT])
+static void loadOperatorPreset(Operator *op,
+                               const u16 operatorParameters[OPERATOR_PARAMETER_COUNT])
 {
     for (u16 p = 0; p < OPERATOR_PARAMETER_COUNT; p++)
     {
@@ -96,7 +109,27 @@ static void loadOperatorPreset(Operator *op, u16 operatorParameters[OPERATOR_PAR
     }
 }
 
-static void setGlobalLFO(u8 enable, u8 freq) { YM2612_writeReg(0, 0x22, (enable << 3) | freq); }
+void synth_setTimerControl(u8 control)
+{
+    megadrive_writeToYm2612Part(0, 0x27, channel3Mode | control);
+}
+
+bool synth_isCh3SpecialMode(void) { return channel3Mode == CH3_SPECIAL_MODE; }
+
+void synth_updateGlides(void)
+{
+    SYS_disableInts();
+    for (u8 c = 0; c < CHANNEL_COUNT; c++)
+    {
+        channel_updateGlide(&channels[c]);
+    }
+    SYS_enableInts();
+}
+
+static void setGlobalLFO(u8 enable, u8 freq)
+{
+    megadrive_writeToYm2612Part(0, 0x22, (enable << 3) | freq);
+}
 
 static void updateGlobalLFO(Channel *chan)
 {
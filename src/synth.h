@@ -23,4 +23,8 @@ void synth_init(void);
 Channel *synth_channel(u8 number);
 void synth_setGlobalParameterValue(GlobalParameters parameter, u16 value);
 u16 synth_globalParameterValue(GlobalParameters parameter);
+u16 synth_globalParameterMaxValue(GlobalParameters parameter);
 void synth_preset(const Preset *preset);
+void synth_setTimerControl(u8 control);
+bool synth_isCh3SpecialMode(void);
+void synth_updateGlides(void);
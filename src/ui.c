@@ -1,94 +1,403 @@
+#include <arpeggiator.h>
+#include <automation.h>
 #include <genesis.h>
 #include <stdbool.h>
 #include <synth.h>
 #include <channel.h>
+#include <latency.h>
+#include <link.h>
+#include <midi.h>
+#include <profiler.h>
+#include <replay.h>
+#include <storage.h>
 #include <ui.h>
 #include <ui_display.h>
 
-#define SELECTION_COUNT GLOBAL_PARAMETER_COUNT + FM_PARAMETER_COUNT + (OPERATOR_PARAMETER_COUNT * OPERATOR_COUNT)
-#define INPUT_RESOLUTION 5
+#define SELECTION_COUNT GLOBAL_PARAMETER_COUNT + ARP_PARAMETER_COUNT + FM_PARAMETER_COUNT + (OPERATOR_PARAMETER_COUNT * OPERATOR_COUNT)
+#define DIRECTION_BUTTONS (BUTTON_LEFT | BUTTON_RIGHT | BUTTON_UP | BUTTON_DOWN)
+#define REPEAT_DELAY 15
+#define REPEAT_INTERVAL 3
+#define ACCELERATION_INTERVAL 30
+#define ACCELERATION_RANGE_SHIFT 5
 
-static void checkPlayButton(u16 joyState, u16 button, Channel *channel, u16 *lastJoyState);
+static void sampleInput(void);
+static void resetInput(void);
+static void checkPlayButton(u16 joyState, u16 pressed, u16 released, u16 button,
+                            Channel *channel, Channel **heldChannel);
+static void stopHeldNote(Channel **heldChannel);
+static void checkArpeggioButton(u16 joyState, u16 pressed, u16 released, u16 button,
+                                Channel *channel);
+static void checkProfilerButton(u16 pressed);
+static bool checkReplayButton(bool pressed);
+static void checkLinkButtons(u16 pressed);
+static void checkAutomationButton(u16 pressed);
 static void modifySelection(u16 joyState, u8 selection, s8 change);
-static void modifyValue(u16 joyState, u8 selection, s8 change);
-static void updateGlobalParameter(u16 joyState, u16 index, s8 change);
-static void updateOpParameter(u16 joyState, u16 index, s8 change);
-static void updateFmParameter(u16 joyState, u16 index, s8 change);
+static void modifyValue(u16 joyState, u8 selection, s16 change);
+static void updateGlobalParameter(u16 joyState, u16 index, s16 change);
+static void updateArpParameter(u16 joyState, u16 index, s16 change);
+static void updateOpParameter(u16 joyState, u16 index, s16 change);
+static void updateFmParameter(u16 joyState, u16 index, s16 change);
+static void setFmParameter(Channel *chan, u16 index, u16 value);
+static void applyFmParameter(Channel *chan, u16 index, u16 value);
+static void setOpParameter(Operator *op, OpParameters opParameter, u16 value);
+static void applyOpParameter(Operator *op, OpParameters opParameter, u16 value);
+static u16 selectionMaxValue(u8 index);
+static u16 selectionValue(u8 chanNumber, u8 index);
+static void setSelectionValue(u8 chanNumber, u8 index, u16 value);
+static void applySelectionValue(u8 chanNumber, u8 index, u16 value);
+static u16 repeatStep(u16 maxValue, u16 holdFrames);
+static u16 steppedValue(u16 value, u16 maxValue, s16 change);
 static u8 nextChannelNumber(u8 chanNum);
 
 static u8 currentSelection = 0;
 static Channel *currentChannel;
+typedef enum {
+    DEBUG_PAGE_NONE,
+    DEBUG_PAGE_PROFILER,
+    DEBUG_PAGE_WRITE_STATS,
+    DEBUG_PAGE_ENVELOPES,
+    DEBUG_PAGE_LATENCY
+} DebugPage;
+
+static DebugPage debugPage = DEBUG_PAGE_NONE;
+
+/*
+ * The joypad is sampled in the VBlank interrupt. Button edges accumulate until
+ * the main loop consumes them, so presses are never lost to a slow frame.
+ */
+static volatile u16 sampledJoyState = 0;
+static volatile u16 pressedButtons = 0;
+static volatile u16 releasedButtons = 0;
+static volatile u16 repeatedButtons = 0;
+static volatile u16 heldFrames = 0;
+static volatile bool replayPressed = false;
+static u16 liveJoyState = 0;
+static Channel *heldChannelA = NULL;
+static Channel *heldChannelB = NULL;
+static u8 replaySelection;
+static u8 replayChannelNumber;
 
 void ui_init(void)
 {
     display_init();
     currentChannel = synth_channel(0);
+    automation_init(selectionValue, applySelectionValue);
+    midi_init(setSelectionValue);
     display_draw(currentChannel, currentSelection);
+    SYS_setVIntCallback(sampleInput);
 }
 
 void ui_checkInput(void)
 {
-    static u16 lastJoyStateA, lastJoyStateB;
-    static u16 tick = 0;
-    u16 joyState = JOY_readJoypad(JOY_1);
+    profiler_begin(PROFILER_INPUT);
 
-    checkPlayButton(joyState, BUTTON_A,
-                    currentChannel, &lastJoyStateA);
-    checkPlayButton(joyState, BUTTON_B,
-                    synth_channel(nextChannelNumber(currentChannel->number)), &lastJoyStateB);
+    SYS_disableInts();
+    u16 joyState = sampledJoyState;
+    u16 pressed = pressedButtons;
+    u16 released = releasedButtons;
+    u16 triggered = pressed | repeatedButtons;
+    u16 held = heldFrames;
+    bool replay = replayPressed;
+    replayPressed = false;
+    pressedButtons = 0;
+    releasedButtons = 0;
+    repeatedButtons = 0;
+    SYS_enableInts();
+
+    if (checkReplayButton(replay))
+    {
+        joyState = 0;
+        pressed = 0;
+        released = 0;
+        triggered = 0;
+        held = 0;
+    }
+    if (pressed & (BUTTON_A | BUTTON_B))
+    {
+        automation_trigger();
+    }
+    checkArpeggioButton(joyState, pressed, released, BUTTON_A, currentChannel);
+    checkPlayButton(joyState, arpeggiator_isEnabled() ? pressed & ~BUTTON_A : pressed, released,
+                    BUTTON_A, currentChannel, &heldChannelA);
+    checkPlayButton(joyState, pressed, released, BUTTON_B,
+                    synth_channel(nextChannelNumber(currentChannel->number)), &heldChannelB);
+    checkProfilerButton(pressed);
+    checkLinkButtons(pressed);
+    checkAutomationButton(pressed);
+
+    if (triggered & (BUTTON_LEFT | BUTTON_RIGHT))
+    {
+        s16 step = repeatStep(selectionMaxValue(currentSelection), held);
+        modifyValue(joyState, currentSelection, (triggered & BUTTON_LEFT) ? -step : step);
+    }
+    else if (triggered & BUTTON_UP)
+    {
+        modifySelection(joyState, currentSelection, -1);
+    }
+    else if (triggered & BUTTON_DOWN)
+    {
+        modifySelection(joyState, currentSelection, 1);
+    }
+    else if (pressed & BUTTON_START)
+    {
+        currentChannel = synth_channel(nextChannelNumber(currentChannel->number));
+        display_showChannel(currentChannel);
+    }
+    profiler_end(PROFILER_INPUT);
 
-    if (tick % INPUT_RESOLUTION == 0)
+    profiler_begin(PROFILER_DISPLAY);
+    display_updateUiIfRequired(currentChannel, currentSelection);
+    display_showFps();
+    if (debugPage == DEBUG_PAGE_PROFILER)
     {
-        if (joyState & BUTTON_LEFT)
+        display_updateProfiler();
+    }
+    else if (debugPage == DEBUG_PAGE_WRITE_STATS)
+    {
+        display_updateWriteStats();
+    }
+    else if (debugPage == DEBUG_PAGE_ENVELOPES)
+    {
+        display_updateEnvelopes();
+    }
+    else if (debugPage == DEBUG_PAGE_LATENCY)
+    {
+        display_updateLatency();
+    }
+    profiler_end(PROFILER_DISPLAY);
+}
+
+static void sampleInput(void)
+{
+    profiler_vblank();
+    JOY_update();
+    u16 live = JOY_readJoypad(JOY_1);
+    bool modePressed = (live & BUTTON_MODE) && !(liveJoyState & BUTTON_MODE);
+    liveJoyState = live;
+    if (modePressed)
+    {
+        replayPressed = true;
+        return;
+    }
+
+    u16 joyState = replay_joypad(live & ~BUTTON_MODE);
+    u16 changed = joyState ^ sampledJoyState;
+    pressedButtons |= changed & joyState;
+    releasedButtons |= changed & ~joyState;
+    sampledJoyState = joyState;
+    if (changed & joyState & BUTTON_A)
+    {
+        latency_markInput(currentChannel->number);
+    }
+    else if (changed & joyState & BUTTON_B)
+    {
+        latency_markInput(nextChannelNumber(currentChannel->number));
+    }
+
+    if (joyState & DIRECTION_BUTTONS)
+    {
+        u16 frames = (changed & DIRECTION_BUTTONS) ? 1 : heldFrames + 1;
+        if (frames >= REPEAT_DELAY && (frames - REPEAT_DELAY) % REPEAT_INTERVAL == 0)
         {
-            modifyValue(joyState, currentSelection, -1);
+            repeatedButtons |= joyState & DIRECTION_BUTTONS;
         }
-        else if (joyState & BUTTON_RIGHT)
+        if (frames != 0)
         {
-            modifyValue(joyState, currentSelection, 1);
+            heldFrames = frames;
         }
-        else if (joyState & BUTTON_UP)
+    }
+    else
+    {
+        heldFrames = 0;
+    }
+}
+
+/* Forgets held buttons and notes, so a replay starts from the same input state */
+static void resetInput(void)
+{
+    SYS_disableInts();
+    sampledJoyState = 0;
+    pressedButtons = 0;
+    releasedButtons = 0;
+    repeatedButtons = 0;
+    heldFrames = 0;
+    SYS_enableInts();
+    heldChannelA = NULL;
+    heldChannelB = NULL;
+}
+
+static u8 nextChannelNumber(u8 chanNum)
+{
+    if (++chanNum == CHANNEL_COUNT)
+    {
+        chanNum = 0;
+    }
+    return chanNum;
+}
+
+/*
+ * A button pressed and released within one frame has both edges set. If it
+ * is still held, the release came first, so it is handled first.
+ */
+static void checkPlayButton(u16 joyState, u16 pressed, u16 released, u16 button,
+                            Channel *channel, Channel **heldChannel)
+{
+    if ((released & button) && (joyState & button))
+    {
+        stopHeldNote(heldChannel);
+    }
+    if (pressed & button)
+    {
+        stopHeldNote(heldChannel);
+        channel_setVelocity(channel, FULL_VELOCITY);
+        channel_playNote(channel);
+        *heldChannel = channel;
+    }
+    if ((released & button) && !(joyState & button))
+    {
+        stopHeldNote(heldChannel);
+    }
+}
+
+static void stopHeldNote(Channel **heldChannel)
+{
+    if (*heldChannel != NULL)
+    {
+        channel_stopNote(*heldChannel);
+        *heldChannel = NULL;
+    }
+}
+
+static void checkArpeggioButton(u16 joyState, u16 pressed, u16 released, u16 button,
+                                Channel *channel)
+{
+    if ((released & button) && (joyState & button))
+    {
+        arpeggiator_stop();
+    }
+    if ((pressed & button) && arpeggiator_isEnabled())
+    {
+        arpeggiator_start(channel);
+    }
+    if ((released & button) && !(joyState & button))
+    {
+        arpeggiator_stop();
+    }
+}
+
+static void checkProfilerButton(u16 pressed)
+{
+    if (pressed & BUTTON_C)
+    {
+        if (debugPage == DEBUG_PAGE_NONE)
         {
-            modifySelection(joyState, currentSelection, -1);
+            debugPage = DEBUG_PAGE_PROFILER;
+            display_showProfiler(TRUE);
         }
-        else if (joyState & BUTTON_DOWN)
+        else if (debugPage == DEBUG_PAGE_PROFILER)
         {
-            modifySelection(joyState, currentSelection, 1);
+            debugPage = DEBUG_PAGE_WRITE_STATS;
+            display_showWriteStats(TRUE);
         }
-        else if (joyState & BUTTON_START)
+        else if (debugPage == DEBUG_PAGE_WRITE_STATS)
         {
-            currentChannel = synth_channel(nextChannelNumber(currentChannel->number));
-            display_requestUiUpdate();
+            debugPage = DEBUG_PAGE_ENVELOPES;
+            display_showWriteStats(FALSE);
+            display_showEnvelopes(TRUE);
+        }
+        else if (debugPage == DEBUG_PAGE_ENVELOPES)
+        {
+            debugPage = DEBUG_PAGE_LATENCY;
+            display_showLatency(TRUE);
+        }
+        else
+        {
+            debugPage = DEBUG_PAGE_NONE;
+            display_showLatency(FALSE);
         }
     }
-
-    display_updateUiIfRequired(currentChannel, currentSelection);
-    tick++;
 }
 
-static u8 nextChannelNumber(u8 chanNum)
+/*
+ * MODE cycles the input replay: record from the current state, then play the
+ * recording back from that same state, then stop. The MODE frame itself is
+ * neither recorded nor acted on. Returns true when a recording or playback
+ * starts, as the input of the current frame is then discarded.
+ */
+static bool checkReplayButton(bool pressed)
 {
-    if (++chanNum == CHANNEL_COUNT)
+    if (!pressed)
     {
-        chanNum = 0;
+        return false;
+    }
+    switch (replay_state())
+    {
+    case REPLAY_IDLE:
+        replaySelection = currentSelection;
+        replayChannelNumber = currentChannel->number;
+        replay_record();
+        resetInput();
+        return true;
+    case REPLAY_RECORDING:
+        currentSelection = replaySelection;
+        currentChannel = synth_channel(replayChannelNumber);
+        replay_play();
+        resetInput();
+        display_showChannel(currentChannel);
+        display_requestUiUpdate();
+        return true;
+    default:
+        replay_stop();
+        return false;
     }
-    return chanNum;
 }
 
-static void checkPlayButton(u16 joyState, u16 button, Channel *channel, u16 *lastJoyState)
+/*
+ * X links or unlinks the current channel, Y the operator of the selected
+ * parameter.
+ */
+static void checkLinkButtons(u16 pressed)
 {
-    if (joyState & button)
+    if (pressed & BUTTON_X)
     {
-        if (!(*lastJoyState & button))
+        link_toggleChannel(currentChannel);
+        display_requestChannelUpdate(currentChannel);
+    }
+    if (pressed & BUTTON_Y)
+    {
+        u8 opSelection = GLOBAL_PARAMETER_COUNT + ARP_PARAMETER_COUNT + FM_PARAMETER_COUNT;
+        if (currentSelection >= opSelection)
         {
-            channel_playNote(channel);
+            link_toggleOperator(currentChannel,
+                                (currentSelection - opSelection) / OPERATOR_PARAMETER_COUNT);
+            display_requestChannelUpdate(currentChannel);
         }
     }
-    else
+}
+
+/*
+ * Z cycles parameter automation: record the parameters edited from now on,
+ * then play them back from each new note, then stop.
+ */
+static void checkAutomationButton(u16 pressed)
+{
+    if (!(pressed & BUTTON_Z))
+    {
+        return;
+    }
+    switch (automation_state())
     {
-        channel_stopNote(channel);
+    case AUTOMATION_IDLE:
+        automation_record();
+        break;
+    case AUTOMATION_RECORDING:
+        automation_play();
+        break;
+    default:
+        automation_stop();
+        display_requestUiUpdate();
+        break;
     }
-    *lastJoyState = joyState;
 }
 
 static void modifySelection(u16 joyState, u8 selection, s8 change)
@@ -106,14 +415,21 @@ static void modifySelection(u16 joyState, u8 selection, s8 change)
     display_requestUiUpdate();
 }
 
-static void modifyValue(u16 joyState, u8 index, s8 change)
+static void modifyValue(u16 joyState, u8 index, s16 change)
 {
+    automation_touch(currentChannel->number, index);
     if (index < GLOBAL_PARAMETER_COUNT)
     {
         updateGlobalParameter(joyState, index, change);
         return;
     }
     index -= GLOBAL_PARAMETER_COUNT;
+    if (index < ARP_PARAMETER_COUNT)
+    {
+        updateArpParameter(joyState, index, change);
+        return;
+    }
+    index -= ARP_PARAMETER_COUNT;
     if (index < FM_PARAMETER_COUNT)
     {
         updateFmParameter(joyState, index, change);
@@ -123,52 +439,243 @@ static void modifyValue(u16 joyState, u8 index, s8 change)
     updateOpParameter(joyState, index, change);
 }
 
-static void updateGlobalParameter(u16 joyState, u16 index, s8 change)
+static u16 selectionMaxValue(u8 index)
 {
-    u16 value = synth_globalParameterValue(index);
-    synth_setGlobalParameterValue(index, value + change);
-    display_requestUiUpdate();
+    if (index < GLOBAL_PARAMETER_COUNT)
+    {
+        return synth_globalParameterMaxValue(index);
+    }
+    index -= GLOBAL_PARAMETER_COUNT;
+    if (index < ARP_PARAMETER_COUNT)
+    {
+        return arpeggiator_parameterMaxValue(index);
+    }
+    index -= ARP_PARAMETER_COUNT;
+    if (index < FM_PARAMETER_COUNT)
+    {
+        return channel_parameterMaxValue(currentChannel, index);
+    }
+    index -= FM_PARAMETER_COUNT;
+    Operator *op = channel_operator(currentChannel, index / OPERATOR_PARAMETER_COUNT);
+    return operator_parameterMaxValue(op, index % OPERATOR_PARAMETER_COUNT);
 }
 
-static void updateFmParameter(u16 joyState, u16 index, s8 change)
+static u16 selectionValue(u8 chanNumber, u8 index)
 {
-    u16 value = channel_parameterValue(currentChannel, index);
-    channel_setParameterValue(currentChannel, index, value + change);
+    Channel *chan = synth_channel(chanNumber);
+    if (index < GLOBAL_PARAMETER_COUNT)
+    {
+        return synth_globalParameterValue(index);
+    }
+    index -= GLOBAL_PARAMETER_COUNT;
+    if (index < ARP_PARAMETER_COUNT)
+    {
+        return arpeggiator_parameterValue(index);
+    }
+    index -= ARP_PARAMETER_COUNT;
+    if (index < FM_PARAMETER_COUNT)
+    {
+        return channel_parameterValue(chan, index);
+    }
+    index -= FM_PARAMETER_COUNT;
+    Operator *op = channel_operator(chan, index / OPERATOR_PARAMETER_COUNT);
+    return operator_parameterValue(op, index % OPERATOR_PARAMETER_COUNT);
+}
+
+static void setSelectionValue(u8 chanNumber, u8 index, u16 value)
+{
+    applySelectionValue(chanNumber, index, value);
+    if (index < GLOBAL_PARAMETER_COUNT)
+    {
+        storage_markGlobalsDirty();
+        display_requestUiUpdate();
+    }
+    else if (index < GLOBAL_PARAMETER_COUNT + ARP_PARAMETER_COUNT)
+    {
+        display_requestUiUpdate();
+    }
+    else
+    {
+        Channel *chan = synth_channel(chanNumber);
+        storage_markChannelDirty(chan);
+        display_requestChannelUpdate(chan);
+    }
+}
+
+/* Changes the sound only, for automation playback which runs every frame */
+static void applySelectionValue(u8 chanNumber, u8 index, u16 value)
+{
+    Channel *chan = synth_channel(chanNumber);
+    if (index < GLOBAL_PARAMETER_COUNT)
+    {
+        synth_setGlobalParameterValue(index, value);
+        return;
+    }
+    index -= GLOBAL_PARAMETER_COUNT;
+    if (index < ARP_PARAMETER_COUNT)
+    {
+        arpeggiator_setParameterValue(index, value);
+        return;
+    }
+    index -= ARP_PARAMETER_COUNT;
+    if (index < FM_PARAMETER_COUNT)
+    {
+        applyFmParameter(chan, index, value);
+        return;
+    }
+    index -= FM_PARAMETER_COUNT;
+    applyOpParameter(channel_operator(chan, index / OPERATOR_PARAMETER_COUNT),
+                     index % OPERATOR_PARAMETER_COUNT, value);
+}
+
+/*
+ * Held values repeat with a step that doubles every ACCELERATION_INTERVAL
+ * frames, up to a 32nd of the parameter's range.
+ */
+static u16 repeatStep(u16 maxValue, u16 holdFrames)
+{
+    u16 maxStep = maxValue >> ACCELERATION_RANGE_SHIFT;
+    u16 step = 1;
+    for (u16 frames = REPEAT_DELAY + ACCELERATION_INTERVAL; frames <= holdFrames && step < maxStep;
+         frames += ACCELERATION_INTERVAL)
+    {
+        step <<= 1;
+    }
+    return (maxStep > 0 && step > maxStep) ? maxStep : step;
+}
+
+static u16 steppedValue(u16 value, u16 maxValue, s16 change)
+{
+    if (change == 1 || change == -1)
+    {
+        return value + change;
+    }
+    s16 newValue = value + change;
+    if (newValue < 0)
+    {
+        return 0;
+    }
+    if (newValue > (s16)maxValue)
+    {
+        return maxValue;
+    }
+    return newValue;
+}
+
+static void updateGlobalParameter(u16 joyState, u16 index, s16 change)
+{
+    u16 value = steppedValue(synth_globalParameterValue(index),
+                             synth_globalParameterMaxValue(index), change);
+    setSelectionValue(currentChannel->number, index, value);
+}
+
+static void updateArpParameter(u16 joyState, u16 index, s16 change)
+{
+    u16 value = steppedValue(arpeggiator_parameterValue(index),
+                             arpeggiator_parameterMaxValue(index), change);
+    setSelectionValue(currentChannel->number, GLOBAL_PARAMETER_COUNT + index, value);
+}
+
+/*
+ * Edits go to every member of the current channel's link group in a single
+ * burst with interrupts held off. Channels are visited in part order and, for
+ * operators, each operator's registers across the part before the next
+ * operator's, so the writes go out in ascending register order.
+ */
+static void updateFmParameter(u16 joyState, u16 index, s16 change)
+{
+    u16 value = steppedValue(channel_parameterValue(currentChannel, index),
+                             channel_parameterMaxValue(currentChannel, index), change);
+    u8 channels = link_channels(currentChannel);
+    SYS_disableInts();
+    for (u8 c = 0; c < CHANNEL_COUNT; c++)
+    {
+        if (channels & (1 << c))
+        {
+            setFmParameter(synth_channel(c), index, value);
+        }
+    }
+    SYS_enableInts();
+}
+
+static void updateOpParameter(u16 joyState, u16 index, s16 change)
+{
+    u8 opNumber = index / OPERATOR_PARAMETER_COUNT;
+    OpParameters opParameter = index % OPERATOR_PARAMETER_COUNT;
+    Operator *op = channel_operator(currentChannel, opNumber);
+    u16 value = steppedValue(operator_parameterValue(op, opParameter),
+                             operator_parameterMaxValue(op, opParameter), change);
+    u8 channels = link_channels(currentChannel);
+    u8 operators = link_operators(currentChannel, opNumber);
+    SYS_disableInts();
+    for (u8 part = 0; part < CHANNEL_COUNT; part += CHANNEL_COUNT / 2)
+    {
+        for (u8 o = 0; o < OPERATOR_COUNT; o++)
+        {
+            if (!(operators & (1 << o)))
+            {
+                continue;
+            }
+            for (u8 c = part; c < part + CHANNEL_COUNT / 2; c++)
+            {
+                if (channels & (1 << c))
+                {
+                    setOpParameter(channel_operator(synth_channel(c), o), opParameter, value);
+                }
+            }
+        }
+    }
+    SYS_enableInts();
+}
+
+static void setFmParameter(Channel *chan, u16 index, u16 value)
+{
+    applyFmParameter(chan, index, value);
+    storage_markChannelDirty(chan);
+    display_requestChannelUpdate(chan);
+}
+
+static void applyFmParameter(Channel *chan, u16 index, u16 value)
+{
+    channel_setParameterValue(chan, index, value);
     if (index == PARAMETER_FREQ || index == PARAMETER_NOTE)
     {
         operator_setParameterValue(
-            channel_operator(currentChannel, 0),
+            channel_operator(chan, CH3_CHANNEL_OPERATOR),
             OP_PARAMETER_CH3_FREQ,
-            channel_parameterValue(currentChannel, PARAMETER_FREQ));
+            channel_parameterValue(chan, PARAMETER_FREQ));
     }
     else if (index == PARAMETER_OCTAVE)
     {
         operator_setParameterValue(
-            channel_operator(currentChannel, 0),
+            channel_operator(chan, CH3_CHANNEL_OPERATOR),
             OP_PARAMETER_CH3_OCTAVE,
-            channel_parameterValue(currentChannel, PARAMETER_OCTAVE));
+            channel_parameterValue(chan, PARAMETER_OCTAVE));
     }
-    display_requestUiUpdate();
 }
 
-static void updateOpParameter(u16 joyState, u16 index, s8 change)
+static void setOpParameter(Operator *op, OpParameters opParameter, u16 value)
 {
-    Operator *op = channel_operator(currentChannel, index / OPERATOR_PARAMETER_COUNT);
-    OpParameters opParameter = index % OPERATOR_PARAMETER_COUNT;
-    u16 value = operator_parameterValue(op, opParameter);
-    operator_setParameterValue(op, opParameter, value + change);
+    Channel *chan = synth_channel(op->chanNumber);
+    applyOpParameter(op, opParameter, value);
+    storage_markChannelDirty(chan);
+    display_requestChannelUpdate(chan);
+}
+
+static void applyOpParameter(Operator *op, OpParameters opParameter, u16 value)
+{
+    Channel *chan = synth_channel(op->chanNumber);
+    operator_setParameterValue(op, opParameter, value);
 
-    if (op->opNumber == 0)
+    if (op->opNumber == CH3_CHANNEL_OPERATOR)
     {
-        if (index == OP_PARAMETER_CH3_FREQ)
+        if (opParameter == OP_PARAMETER_CH3_FREQ)
         {
-            channel_setParameterValue(currentChannel, PARAMETER_FREQ, value + change);
+            channel_setParameterValue(chan, PARAMETER_FREQ, value);
         }
-        else if (index == OP_PARAMETER_CH3_OCTAVE)
+        else if (opParameter == OP_PARAMETER_CH3_OCTAVE)
         {
-            channel_setParameterValue(currentChannel, PARAMETER_OCTAVE, value + change);
+            channel_setParameterValue(chan, PARAMETER_OCTAVE, value);
         }
     }
-
-    display_requestUiUpdate();
 }
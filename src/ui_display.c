@@ -1,5 +1,14 @@
 #include <channel.h>
+#include <arpeggiator.h>
+#include <automation.h>
+#include <envelope.h>
 #include <genesis.h>
+#include <latency.h>
+#include <link.h>
+#include <megadrive.h>
+#include <ports.h>
+#include <profiler.h>
+#include <replay.h>
 #include <stdbool.h>
 #include <synth.h>
 #include <ui_display.h>
@@ -9,11 +18,48 @@
 
 #define LEFT_MARGIN 1
 #define GLOBAL_PARAMETERS_TOP_ROW 2
+#define ARP_PARAMETERS_TOP_ROW 3
+#define RIGHT_HEADING_COLUMN 23
+#define RIGHT_VALUE_COLUMN 28
 #define FM_PARAMETERS_VALUE_COLUMN LEFT_MARGIN + 10
 #define FM_PARAMETERS_TOP_ROW 5
 #define OPERATOR_VALUE_COLUMN LEFT_MARGIN + 10
 #define OPERATOR_VALUE_WIDTH 6
-#define OPERATOR_TOP_ROW 14
+#define OPERATOR_TOP_ROW 15
+
+#define PAGE_WIDTH 40
+#define PAGES_PER_SLOT 3
+#define PAGE_SLOT_VRAM 0x2000
+#define PAGE_SLOT_SIZE 0x2000
+#define PAGE_SLOT_COUNT 2
+#define PLANE_B_VRAM (PAGE_SLOT_VRAM + PAGE_SLOT_SIZE * PAGE_SLOT_COUNT)
+#define PLANE_WIDTH 128
+#define PLANE_HEIGHT 32
+#define FPS_COLUMN 1
+#define FPS_ROW 1
+
+#define PROFILER_TOP_ROW 20
+#define PROFILER_BAR_COLUMN 9
+#define PROFILER_BAR_WIDTH 20
+#define PROFILER_STATS_COLUMN 29
+
+#define WRITE_STATS_TOP_ROW 15
+#define HEATMAP_FIRST_REGISTER 0x20
+#define HEATMAP_ROWS 10
+#define HEATMAP_PART_COLUMN 5
+#define HEATMAP_PART_SPACING 17
+
+#define METER_TOP_ROW 25
+#define METER_COLUMN 5
+#define METER_SPACING 6
+#define METER_TILE TILE_USERINDEX
+#define METER_HEIGHTS 9
+#define METER_TILE_ROWS 8
+#define METER_ROW_PIXELS 0x0FFFFFF0
+
+#define LATENCY_TOP_ROW 23
+#define LATENCY_COLUMN 7
+#define LATENCY_AXIS_STEP 8
 
 static void printNumber(u16 number, u16 minSize, u16 x, u16 y);
 static void printNote(u16 index, u16 x, u16 y);
@@ -21,6 +67,7 @@ static void printOnOff(u16 index, u16 x, u16 y);
 static void printLFOFreq(u16 index, u16 x, u16 y);
 static void printLookup(u16 index, const char *text, u16 x, u16 y);
 static void printGlobalParameters(u8 selection);
+static void printArpParameters(u8 selection);
 static void printFmHeader(Channel *chan);
 static void printFmParameters(Channel *chan, u8 selection);
 static void printOperators(Channel *chan, u8 selection);
@@ -31,16 +78,36 @@ static void printAlgorithm(u16 index, u16 x, u16 y);
 static void printAms(u16 index, u16 x, u16 y);
 static void printFms(u16 index, u16 x, u16 y);
 static void printMultiple(u16 index, u16 x, u16 y);
-static void printParameter(u16 index, u16 heading_x, u16 value_x, u16 y, u8 selection);
+static void printArpMode(u16 index, u16 x, u16 y);
+static void printArpShape(u16 index, u16 x, u16 y);
+static void printParameter(FmParameterUi *p, u16 value, bool selected, u16 heading_x, u16 value_x,
+                           u16 y);
+static void drawPage(u8 page, u8 selection);
+static void showPage(u8 page);
+static void clearPages(void);
+static void setTextPalette(u16 palette);
+static void drawText(const char *text, u16 x, u16 y);
+static void clearText(u16 x, u16 y, u16 w);
+static void printProfilerSection(ProfilerSection section, u16 row);
+static void printReplay(u16 row);
+static void printWriteBacklog(u16 row);
+static void printHeatmapRow(u16 row, u8 firstRegister);
+static void loadMeterTiles(void);
+static void printLatencyHistogram(const LatencyStats *stats, u16 row);
 
 static FmParameterUi globalParameterUis[] = {{"Globl LFO", 1, NULL, printOnOff},
                                              {"Freq", 1, NULL, printLFOFreq}};
 
+static FmParameterUi arpParameterUis[] = {{"Arpeggio", 1, NULL, printArpMode},
+                                          {"Shape", 1, NULL, printArpShape},
+                                          {"Rate", 2, NULL, NULL}};
+
 static FmParameterUi fmParameterUis[] = {
     {"Note", 2, NULL, printNote},   {"Freq #", 4, NULL, NULL},
     {"Octave", 1, NULL, NULL},      {"Algorithm", 1, NULL, printAlgorithm},
     {"Feedback", 1, NULL, NULL},    {"LFO AMS", 1, NULL, printAms},
-    {"LFO FMS", 1, NULL, printFms}, {"Stereo", 1, NULL, printStereo}};
+    {"LFO FMS", 1, NULL, printFms}, {"Stereo", 1, NULL, printStereo},
+    {"Glide", 2, NULL, NULL},       {"Legato", 1, NULL, printOnOff}};
 
 static OperatorParameterUi opParameterUis[] = {
     {"Detune", 1, NULL},    {"Multiple", 2, printMultiple},
@@ -50,50 +117,472 @@ static OperatorParameterUi opParameterUis[] = {
     {"Sub Level", 2, NULL}, {"Rel Rate", 2, NULL},
     {"Octave", 1, NULL},    {"Freq #", 4, NULL}};
 
-static bool drawUi = false;
+static const char PROFILER_SECTION_NAMES[PROFILER_SECTION_COUNT][8] = {
+    "Input", "Display", "YM2612", "Audio", "Env"};
+
+/*
+ * Each channel has its own pre-rendered page of plane A. Pages are packed
+ * three abreast in 128-cell wide planes held in two VRAM slots, so showing
+ * a channel is just a plane A base address and horizontal scroll change.
+ * Pages of hidden channels are redrawn in the background, one per frame.
+ * SGDK's FPS counter would draw at a fixed plane A cell, which is only on
+ * screen for some pages, so the count is drawn into the page being shown.
+ */
+static u8 dirtyPages = 0;
+static u8 targetPage = 0;
+static u8 shownPage = 0;
+static u16 shownFps = 0xFFFF;
+static u16 textBaseTile;
+static u8 meterHeights[CHANNEL_COUNT][OPERATOR_COUNT];
 
 void display_init(void)
 {
     VDP_setPaletteColor((PAL1 * 16) + 15, 0x0C55);
     VDP_setPaletteColor((PAL2 * 16) + 15, 0x00DE);
     VDP_setPaletteColor((PAL3 * 16) + 15, 0x00F0);
-    VDP_setTextPalette(PAL2);
-    VDP_drawText("Yamaha YM2612 Test", 10, 0);
+    VDP_setPlaneSize(PLANE_WIDTH, PLANE_HEIGHT, FALSE);
+    VDP_setBGBAddress(PLANE_B_VRAM);
+    clearPages();
+    loadMeterTiles();
+    setTextPalette(PAL2);
+    for (u8 page = 0; page < CHANNEL_COUNT; page++)
+    {
+        targetPage = page;
+        drawText("Yamaha YM2612 Test", 10, 0);
+    }
+    showPage(0);
 }
 
 void display_draw(Channel *chan, u8 selection)
 {
+    for (u8 page = 0; page < CHANNEL_COUNT; page++)
+    {
+        drawPage(page, selection);
+    }
+    dirtyPages = 0;
+    showPage(chan->number);
+}
+
+void display_showChannel(Channel *chan) { showPage(chan->number); }
+
+void display_showFps(void)
+{
+    u16 fps = SYS_getFPS();
+    if (fps == shownFps)
+    {
+        return;
+    }
+    shownFps = fps;
+    char text[8];
+    sprintf(text, "%u  ", fps);
+    u8 page = targetPage;
+    u16 baseTile = textBaseTile;
+    targetPage = shownPage;
+    setTextPalette(PAL0);
+    drawText(text, FPS_COLUMN, FPS_ROW);
+    targetPage = page;
+    textBaseTile = baseTile;
+}
+
+void display_requestUiUpdate(void) { dirtyPages = (1 << CHANNEL_COUNT) - 1; }
+
+void display_requestChannelUpdate(Channel *chan) { dirtyPages |= 1 << chan->number; }
+
+void display_updateUiIfRequired(Channel *chan, u8 selection)
+{
+    if (dirtyPages == 0)
+    {
+        return;
+    }
+    u8 page = chan->number;
+    if (!(dirtyPages & (1 << page)))
+    {
+        page = 0;
+        while (!(dirtyPages & (1 << page)))
+        {
+            page++;
+        }
+    }
+    dirtyPages &= ~(1 << page);
+    drawPage(page, selection);
+}
+
+void display_showProfiler(bool show)
+{
+    if (show)
+    {
+        VDP_clearPlane(WINDOW, TRUE);
+        VDP_setTextPalette(PAL_HEADING);
+        VDP_drawTextBG(WINDOW, "Profiler", LEFT_MARGIN, PROFILER_TOP_ROW);
+        VDP_drawTextBG(WINDOW, "Budget", PROFILER_BAR_COLUMN, PROFILER_TOP_ROW);
+        VDP_drawTextBG(WINDOW, "Min Avg Max", PROFILER_STATS_COLUMN, PROFILER_TOP_ROW);
+        VDP_setTextPalette(PAL0);
+        VDP_setWindowVPos(TRUE, PROFILER_TOP_ROW);
+    }
+    else
+    {
+        VDP_setWindowVPos(FALSE, 0);
+    }
+}
+
+void display_updateProfiler(void)
+{
+    if (!profiler_hasNewStats())
+    {
+        return;
+    }
+    for (u16 section = 0; section < PROFILER_SECTION_COUNT; section++)
+    {
+        printProfilerSection(section, PROFILER_TOP_ROW + 1 + section);
+    }
+    printReplay(PROFILER_TOP_ROW + 1 + PROFILER_SECTION_COUNT);
+    printWriteBacklog(PROFILER_TOP_ROW + 2 + PROFILER_SECTION_COUNT);
+}
+
+/*
+ * The write statistics page shows each register as a digit, the log2 of the
+ * writes requested since the last refresh plus one ('.' for none), with the
+ * two parts side by side, one row per 16 registers.
+ */
+void display_showWriteStats(bool show)
+{
+    if (show)
+    {
+        VDP_clearPlane(WINDOW, TRUE);
+        VDP_setTextPalette(PAL_HEADING);
+        VDP_drawTextBG(WINDOW, "Reg", LEFT_MARGIN, WRITE_STATS_TOP_ROW);
+        for (u8 part = 0; part < 2; part++)
+        {
+            VDP_drawTextBG(WINDOW, "0123456789ABCDEF",
+                           HEATMAP_PART_COLUMN + part * HEATMAP_PART_SPACING, WRITE_STATS_TOP_ROW);
+        }
+        VDP_setTextPalette(PAL0);
+        VDP_setWindowVPos(TRUE, WRITE_STATS_TOP_ROW);
+    }
+    else
+    {
+        VDP_setWindowVPos(FALSE, 0);
+    }
+    megadrive_setWriteStatsEnabled(show);
+}
+
+void display_updateWriteStats(void)
+{
+    if (!profiler_hasNewStats())
+    {
+        return;
+    }
+    for (u8 row = 0; row < HEATMAP_ROWS; row++)
+    {
+        printHeatmapRow(WRITE_STATS_TOP_ROW + 1 + row, HEATMAP_FIRST_REGISTER + row * 16);
+    }
+    const WriteStats *stats = megadrive_writeStats();
+    char text[40];
+    sprintf(text, "%3u Peak %3u  Req %5u Wr %5u", stats->frameWrites, stats->peakFrameWrites,
+            stats->requests, stats->writes);
+    u16 row = WRITE_STATS_TOP_ROW + 1 + HEATMAP_ROWS;
+    VDP_setTextPalette(PAL_HEADING);
+    VDP_drawTextBG(WINDOW, "Frame", LEFT_MARGIN, row);
+    VDP_drawTextBG(WINDOW, "Busy", LEFT_MARGIN, row + 1);
+    VDP_setTextPalette(PAL0);
+    VDP_drawTextBG(WINDOW, text, PROFILER_BAR_COLUMN - 2, row);
+    sprintf(text, "Avg %3u Peak %3u polls", stats->averageBusy, stats->peakBusy);
+    VDP_drawTextBG(WINDOW, text, PROFILER_BAR_COLUMN - 2, row + 1);
+    megadrive_clearWriteStats();
+}
+
+/*
+ * The envelope page shows one meter cell per operator, grouped by channel.
+ * Each cell is one of nine bar tiles, from empty to full height. Only cells
+ * whose height changed are rewritten, so a frame costs at most 24 tile
+ * writes.
+ */
+void display_showEnvelopes(bool show)
+{
+    if (show)
+    {
+        VDP_clearPlane(WINDOW, TRUE);
+        VDP_setTextPalette(PAL_HEADING);
+        VDP_drawTextBG(WINDOW, "Env", LEFT_MARGIN, METER_TOP_ROW);
+        VDP_drawTextBG(WINDOW, "Op", LEFT_MARGIN, METER_TOP_ROW + 2);
+        for (u8 chanNumber = 0; chanNumber < CHANNEL_COUNT; chanNumber++)
+        {
+            char text[4];
+            sprintf(text, "Ch%u", chanNumber + 1);
+            u16 column = METER_COLUMN + chanNumber * METER_SPACING;
+            VDP_drawTextBG(WINDOW, text, column, METER_TOP_ROW);
+            VDP_drawTextBG(WINDOW, "1234", column, METER_TOP_ROW + 2);
+        }
+        VDP_setTextPalette(PAL0);
+        memset(meterHeights, 0xFF, sizeof(meterHeights));
+        VDP_setWindowVPos(TRUE, METER_TOP_ROW);
+    }
+    else
+    {
+        VDP_setWindowVPos(FALSE, 0);
+    }
+}
+
+void display_updateEnvelopes(void)
+{
+    for (u8 chanNumber = 0; chanNumber < CHANNEL_COUNT; chanNumber++)
+    {
+        for (u8 opNumber = 0; opNumber < OPERATOR_COUNT; opNumber++)
+        {
+            u16 level = ENVELOPE_SILENT - envelope_level(chanNumber, opNumber);
+            u8 height = (level * METER_HEIGHTS) >> 10;
+            if (height != meterHeights[chanNumber][opNumber])
+            {
+                meterHeights[chanNumber][opNumber] = height;
+                VDP_setTileMapXY(WINDOW,
+                                 TILE_ATTR_FULL(PAL2, FALSE, FALSE, FALSE, METER_TILE + height),
+                                 METER_COLUMN + chanNumber * METER_SPACING + opNumber,
+                                 METER_TOP_ROW + 1);
+            }
+        }
+    }
+}
+
+/*
+ * The latency page shows key on latency in scanlines as a histogram of
+ * LATENCY_BUCKET_LINES wide buckets drawn with the meter tiles, scaled to
+ * the fullest bucket. Samples are collected from when the page is opened.
+ */
+void display_showLatency(bool show)
+{
+    if (show)
+    {
+        VDP_clearPlane(WINDOW, TRUE);
+        VDP_setTextPalette(PAL_HEADING);
+        VDP_drawTextBG(WINDOW, "Latency", LEFT_MARGIN, LATENCY_TOP_ROW);
+        VDP_drawTextBG(WINDOW, "Keys", LEFT_MARGIN, LATENCY_TOP_ROW + 1);
+        VDP_drawTextBG(WINDOW, "Lines", LEFT_MARGIN, LATENCY_TOP_ROW + 3);
+        for (u8 bucket = 0; bucket < LATENCY_BUCKET_COUNT; bucket += LATENCY_AXIS_STEP)
+        {
+            char text[5];
+            sprintf(text, "%u", bucket * LATENCY_BUCKET_LINES);
+            VDP_drawTextBG(WINDOW, text, LATENCY_COLUMN + bucket, LATENCY_TOP_ROW + 3);
+        }
+        VDP_setTextPalette(PAL0);
+        latency_reset();
+        VDP_setWindowVPos(TRUE, LATENCY_TOP_ROW);
+    }
+    else
+    {
+        VDP_setWindowVPos(FALSE, 0);
+    }
+}
+
+void display_updateLatency(void)
+{
+    if (!latency_hasNewSample())
+    {
+        return;
+    }
+    const LatencyStats *stats = latency_stats();
+    char text[40];
+    sprintf(text, "%5u Min %4u Avg %4u Max %4u", stats->count, stats->min,
+            stats->count == 0 ? 0 : (u16)(stats->total / stats->count), stats->max);
+    VDP_drawTextBG(WINDOW, text, LATENCY_COLUMN, LATENCY_TOP_ROW + 1);
+    printLatencyHistogram(stats, LATENCY_TOP_ROW + 2);
+}
+
+static void printLatencyHistogram(const LatencyStats *stats, u16 row)
+{
+    u16 fullest = 1;
+    for (u8 bucket = 0; bucket < LATENCY_BUCKET_COUNT; bucket++)
+    {
+        if (stats->buckets[bucket] > fullest)
+        {
+            fullest = stats->buckets[bucket];
+        }
+    }
+    for (u8 bucket = 0; bucket < LATENCY_BUCKET_COUNT; bucket++)
+    {
+        u16 count = stats->buckets[bucket];
+        u16 height = ((u32)count * (METER_HEIGHTS - 1) + fullest - 1) / fullest;
+        VDP_setTileMapXY(WINDOW, TILE_ATTR_FULL(PAL2, FALSE, FALSE, FALSE, METER_TILE + height),
+                         LATENCY_COLUMN + bucket, row);
+    }
+}
+
+static void loadMeterTiles(void)
+{
+    u32 tiles[METER_HEIGHTS * METER_TILE_ROWS];
+    for (u8 height = 0; height < METER_HEIGHTS; height++)
+    {
+        for (u8 row = 0; row < METER_TILE_ROWS; row++)
+        {
+            tiles[height * METER_TILE_ROWS + row] =
+                row >= METER_TILE_ROWS - height ? METER_ROW_PIXELS : 0;
+        }
+    }
+    VDP_loadTileData(tiles, METER_TILE, METER_HEIGHTS, CPU);
+}
+
+static void printHeatmapRow(u16 row, u8 firstRegister)
+{
+    char label[3];
+    sprintf(label, "%X", firstRegister >> 4);
+    label[1] = 'x';
+    label[2] = 0;
+    VDP_setTextPalette(PAL_HEADING);
+    VDP_drawTextBG(WINDOW, label, LEFT_MARGIN, row);
+    VDP_setTextPalette(PAL0);
+    for (u8 part = 0; part < 2; part++)
+    {
+        const u8 *counts = megadrive_requestCounts(part) + firstRegister;
+        char cells[17];
+        for (u8 i = 0; i < 16; i++)
+        {
+            u8 count = counts[i];
+            char cell = '.';
+            while (count != 0)
+            {
+                cell = cell == '.' ? '1' : cell + 1;
+                count >>= 1;
+            }
+            cells[i] = cell;
+        }
+        cells[16] = 0;
+        VDP_drawTextBG(WINDOW, cells, HEATMAP_PART_COLUMN + part * HEATMAP_PART_SPACING, row);
+    }
+}
+
+static void printWriteBacklog(u16 row)
+{
+    char text[30];
+    sprintf(text, "Env %3u Tim %3u Blk %3u", megadrive_writeBacklog(WRITE_CLASS_ENVELOPE),
+            megadrive_writeBacklog(WRITE_CLASS_TIMBRE), megadrive_writeBacklog(WRITE_CLASS_BULK));
+    VDP_setTextPalette(PAL_HEADING);
+    VDP_drawTextBG(WINDOW, "Queue", LEFT_MARGIN, row);
+    VDP_setTextPalette(PAL0);
+    VDP_drawTextBG(WINDOW, text, PROFILER_BAR_COLUMN, row);
+}
+
+static void printReplay(u16 row)
+{
+    const char STATES[][5] = {"Off ", "Rec ", "Play"};
+    char text[31];
+    sprintf(text, "%s %5u  Sig %04X  Aut %s", STATES[replay_state()], replay_writeCount(),
+            replay_signature(), STATES[automation_state()]);
+    VDP_setTextPalette(PAL_HEADING);
+    VDP_drawTextBG(WINDOW, "Replay", LEFT_MARGIN, row);
+    VDP_setTextPalette(PAL0);
+    VDP_drawTextBG(WINDOW, text, PROFILER_BAR_COLUMN, row);
+}
+
+static void printProfilerSection(ProfilerSection section, u16 row)
+{
+    const ProfilerStats *stats = profiler_stats(section);
+    u16 frameLines = profiler_frameLines();
+    u16 avgCells = (stats->avg * PROFILER_BAR_WIDTH + frameLines - 1) / frameLines;
+    u16 maxCells = (stats->max * PROFILER_BAR_WIDTH + frameLines - 1) / frameLines;
+    char bar[PROFILER_BAR_WIDTH + 1];
+    for (u16 i = 0; i < PROFILER_BAR_WIDTH; i++)
+    {
+        bar[i] = i < avgCells ? '=' : i < maxCells ? '-' : '.';
+    }
+    bar[PROFILER_BAR_WIDTH] = 0;
+    char numbers[18];
+    sprintf(numbers, "%3u %3u %3u", stats->min, stats->avg, stats->max);
+
+    VDP_setTextPalette(PAL_HEADING);
+    VDP_drawTextBG(WINDOW, PROFILER_SECTION_NAMES[section], LEFT_MARGIN, row);
+    VDP_setTextPalette(maxCells > PROFILER_BAR_WIDTH ? PAL_SELECTION : PAL0);
+    VDP_drawTextBG(WINDOW, bar, PROFILER_BAR_COLUMN, row);
+    VDP_setTextPalette(PAL0);
+    VDP_drawTextBG(WINDOW, numbers, PROFILER_STATS_COLUMN, row);
+}
+
+static void drawPage(u8 page, u8 selection)
+{
+    Channel *chan = synth_channel(page);
+    targetPage = page;
     printGlobalParameters(selection);
+    printArpParameters(selection);
     printFmParameters(chan, selection);
     printOperators(chan, selection);
-    VDP_setTextPalette(PAL0);
+    setTextPalette(PAL0);
 }
 
-void display_requestUiUpdate(void) { drawUi = true; }
+static void showPage(u8 page)
+{
+    shownPage = page;
+    shownFps = 0xFFFF;
+    VDP_setBGAAddress(PAGE_SLOT_VRAM + PAGE_SLOT_SIZE * (page / PAGES_PER_SLOT));
+    VDP_setHorizontalScroll(BG_A, -(PAGE_WIDTH * 8) * (page % PAGES_PER_SLOT));
+}
 
-void display_updateUiIfRequired(Channel *chan, u8 selection)
+static void clearPages(void)
 {
-    if (drawUi)
+    PORT_WRITE_U32(GFX_CTRL_PORT, GFX_WRITE_VRAM_ADDR(PAGE_SLOT_VRAM));
+    for (u16 i = 0; i < (PAGE_SLOT_SIZE * (PAGE_SLOT_COUNT + 1)) / 2; i++)
     {
-        drawUi = false;
-        display_draw(chan, selection);
+        PORT_WRITE_U16(GFX_DATA_PORT, 0);
     }
 }
 
+static void setTextPalette(u16 palette)
+{
+    textBaseTile = TILE_ATTR_FULL(palette, FALSE, FALSE, FALSE, TILE_FONTINDEX);
+}
+
+static void drawText(const char *text, u16 x, u16 y)
+{
+    u16 column = (targetPage % PAGES_PER_SLOT) * PAGE_WIDTH + x;
+    u16 address = PAGE_SLOT_VRAM + PAGE_SLOT_SIZE * (targetPage / PAGES_PER_SLOT) +
+                  ((y * PLANE_WIDTH) + column) * 2;
+    PORT_WRITE_U32(GFX_CTRL_PORT, GFX_WRITE_VRAM_ADDR(address));
+    while (*text && x++ < PAGE_WIDTH)
+    {
+        PORT_WRITE_U16(GFX_DATA_PORT, textBaseTile + (*text++ - 32));
+    }
+}
+
+static void clearText(u16 x, u16 y, u16 w)
+{
+    char blank[PAGE_WIDTH + 1];
+    memset(blank, ' ', w);
+    blank[w] = 0;
+    drawText(blank, x, y);
+}
+
 static void printGlobalParameters(u8 selection)
 {
-    printParameter(0, LEFT_MARGIN, FM_PARAMETERS_VALUE_COLUMN, GLOBAL_PARAMETERS_TOP_ROW,
-                   selection);
-    printParameter(1, 23, 28, GLOBAL_PARAMETERS_TOP_ROW, selection);
+    printParameter(&globalParameterUis[PARAMETER_G_LFO_ON],
+                   synth_globalParameterValue(PARAMETER_G_LFO_ON),
+                   selection == PARAMETER_G_LFO_ON, LEFT_MARGIN, FM_PARAMETERS_VALUE_COLUMN,
+                   GLOBAL_PARAMETERS_TOP_ROW);
+    printParameter(&globalParameterUis[PARAMETER_G_LFO_FREQ],
+                   synth_globalParameterValue(PARAMETER_G_LFO_FREQ),
+                   selection == PARAMETER_G_LFO_FREQ, RIGHT_HEADING_COLUMN, RIGHT_VALUE_COLUMN,
+                   GLOBAL_PARAMETERS_TOP_ROW);
 }
 
-static void printParameter(u16 index, u16 heading_x, u16 value_x, u16 y, u8 selection)
+static void printArpParameters(u8 selection)
 {
-    FmParameterUi *p = &globalParameterUis[index];
-    u16 value = synth_globalParameterValue(index);
-    VDP_setTextPalette(PAL_HEADING);
-    VDP_drawText(p->name, heading_x, y);
-    VDP_setTextPalette(selection == index ? PAL_SELECTION : PAL0);
+    u8 arpSelection = selection - GLOBAL_PARAMETER_COUNT;
+    printParameter(&arpParameterUis[PARAMETER_ARP_MODE],
+                   arpeggiator_parameterValue(PARAMETER_ARP_MODE),
+                   arpSelection == PARAMETER_ARP_MODE, LEFT_MARGIN, FM_PARAMETERS_VALUE_COLUMN,
+                   ARP_PARAMETERS_TOP_ROW);
+    printParameter(&arpParameterUis[PARAMETER_ARP_SHAPE],
+                   arpeggiator_parameterValue(PARAMETER_ARP_SHAPE),
+                   arpSelection == PARAMETER_ARP_SHAPE, RIGHT_HEADING_COLUMN, RIGHT_VALUE_COLUMN,
+                   ARP_PARAMETERS_TOP_ROW);
+    printParameter(&arpParameterUis[PARAMETER_ARP_RATE],
+                   arpeggiator_parameterValue(PARAMETER_ARP_RATE),
+                   arpSelection == PARAMETER_ARP_RATE, RIGHT_HEADING_COLUMN, RIGHT_VALUE_COLUMN,
+                   ARP_PARAMETERS_TOP_ROW + 1);
+}
+
+static void printParameter(FmParameterUi *p, u16 value, bool selected, u16 heading_x, u16 value_x,
+                           u16 y)
+{
+    setTextPalette(PAL_HEADING);
+    drawText(p->name, heading_x, y);
+    setTextPalette(selected ? PAL_SELECTION : PAL0);
     if (p->printFunc != NULL)
     {
         p->printFunc(value, value_x, y);
@@ -111,9 +600,11 @@ static void printFmParameters(Channel *chan, u8 selection)
     {
         u16 row = index + FM_PARAMETERS_TOP_ROW;
         FmParameterUi *p = &fmParameterUis[index];
-        VDP_setTextPalette(PAL_HEADING);
-        VDP_drawText(p->name, LEFT_MARGIN, row);
-        VDP_setTextPalette(selection == index + GLOBAL_PARAMETER_COUNT ? PAL_SELECTION : PAL0);
+        setTextPalette(PAL_HEADING);
+        drawText(p->name, LEFT_MARGIN, row);
+        setTextPalette(selection == index + GLOBAL_PARAMETER_COUNT + ARP_PARAMETER_COUNT
+                           ? PAL_SELECTION
+                           : PAL0);
         u16 value = channel_parameterValue(chan, index);
         if (p->printFunc != NULL)
         {
@@ -138,21 +629,22 @@ static void printOperators(Channel *chan, u8 selection)
 
 static void printFmHeader(Channel *chan)
 {
-    VDP_setTextPalette(PAL_HEADING);
-    char opHeader[4];
-    sprintf(opHeader, "Ch%u", chan->number + 1);
-    VDP_drawText(opHeader, FM_PARAMETERS_VALUE_COLUMN, FM_PARAMETERS_TOP_ROW - 1);
-    VDP_setTextPalette(PAL0);
+    setTextPalette(PAL_HEADING);
+    char opHeader[5];
+    sprintf(opHeader, link_isChannelLinked(chan) ? "Ch%u*" : "Ch%u ", chan->number + 1);
+    drawText(opHeader, FM_PARAMETERS_VALUE_COLUMN, FM_PARAMETERS_TOP_ROW - 1);
+    setTextPalette(PAL0);
 }
 
 static void printOperatorHeader(Operator *op)
 {
-    VDP_setTextPalette(PAL_HEADING);
-    char opHeader[4];
-    sprintf(opHeader, "Op%u", op->opNumber + 1);
-    VDP_drawText(opHeader, OPERATOR_VALUE_WIDTH * op->opNumber + OPERATOR_VALUE_COLUMN,
+    setTextPalette(PAL_HEADING);
+    char opHeader[5];
+    bool linked = link_isOperatorLinked(synth_channel(op->chanNumber), op->opNumber);
+    sprintf(opHeader, linked ? "Op%u*" : "Op%u ", op->opNumber + 1);
+    drawText(opHeader, OPERATOR_VALUE_WIDTH * op->opNumber + OPERATOR_VALUE_COLUMN,
                  OPERATOR_TOP_ROW);
-    VDP_setTextPalette(PAL0);
+    setTextPalette(PAL0);
 }
 
 static void printOperator(Operator *op, u8 selection)
@@ -163,20 +655,21 @@ static void printOperator(Operator *op, u8 selection)
         if (op->chanNumber != 2 &&
             (index == OP_PARAMETER_CH3_FREQ || index == OP_PARAMETER_CH3_OCTAVE))
         {
-            VDP_clearText(LEFT_MARGIN, row, 40);
+            clearText(LEFT_MARGIN, row, 40);
             continue;
         }
 
         if (op->opNumber == 0)
         {
-            VDP_setTextPalette(PAL_HEADING);
-            VDP_drawText(opParameterUis[index].name, LEFT_MARGIN, row);
-            VDP_setTextPalette(PAL0);
+            setTextPalette(PAL_HEADING);
+            drawText(opParameterUis[index].name, LEFT_MARGIN, row);
+            setTextPalette(PAL0);
         }
         if (selection - FM_PARAMETER_COUNT ==
-            GLOBAL_PARAMETER_COUNT + index + op->opNumber * OPERATOR_PARAMETER_COUNT)
+            GLOBAL_PARAMETER_COUNT + ARP_PARAMETER_COUNT + index +
+                op->opNumber * OPERATOR_PARAMETER_COUNT)
         {
-            VDP_setTextPalette(PAL_SELECTION);
+            setTextPalette(PAL_SELECTION);
         }
         OperatorParameterUi *opUi = &opParameterUis[index];
         if (opUi->printFunc != NULL)
@@ -189,7 +682,7 @@ static void printOperator(Operator *op, u8 selection)
             printNumber(operator_parameterValue(op, index), opParameterUis[index].minSize,
                         OPERATOR_VALUE_WIDTH * op->opNumber + OPERATOR_VALUE_COLUMN, row);
         }
-        VDP_setTextPalette(PAL0);
+        setTextPalette(PAL0);
     }
 }
 
@@ -200,6 +693,18 @@ static void printLFOFreq(u16 index, u16 x, u16 y)
     printLookup(index, TEXT[index], x, y);
 }
 
+static void printArpMode(u16 index, u16 x, u16 y)
+{
+    const char TEXT[][7] = {"Off", "Up", "Down", "Random", "Chord"};
+    printLookup(index, TEXT[index], x, y);
+}
+
+static void printArpShape(u16 index, u16 x, u16 y)
+{
+    const char TEXT[][5] = {"Maj", "Min", "Maj7", "Min7", "Sus4", "Oct"};
+    printLookup(index, TEXT[index], x, y);
+}
+
 static void printOnOff(u16 index, u16 x, u16 y)
 {
     const char TEXT[][4] = {"Off", "On"};
@@ -239,7 +744,7 @@ static void printFms(u16 index, u16 x, u16 y)
 
 static void printMultiple(u16 index, u16 x, u16 y)
 {
-    char buffer[4];
+    char buffer[7];
     if (index == 0)
     {
         strcpy(buffer, ".5");
@@ -248,19 +753,19 @@ static void printMultiple(u16 index, u16 x, u16 y)
     {
         sprintf(buffer, "%u ", index);
     }
-    VDP_drawText(buffer, x, y);
+    drawText(buffer, x, y);
 }
 
 static void printLookup(u16 index, const char *text, u16 x, u16 y)
 {
     char buffer[25];
     sprintf(buffer, "%s (%u)     ", text, index);
-    VDP_drawText(buffer, x, y);
+    drawText(buffer, x, y);
 }
 
 static void printNumber(u16 number, u16 minSize, u16 x, u16 y)
 {
     char str[5];
     uintToStr(number, str, minSize);
-    VDP_drawText(str, x, y);
+    drawText(str, x, y);
 }
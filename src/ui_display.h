@@ -1,5 +1,6 @@
 #pragma once
 #include <genesis.h>
+#include <stdbool.h>
 #include <synth.h>
 
 typedef struct
@@ -20,4 +21,15 @@ typedef struct
 void display_init(void);
 void display_draw(Channel *chan, u8 selection);
 void display_updateUiIfRequired(Channel *chan, u8 selection);
+void display_showFps(void);
 void display_requestUiUpdate(void);
+void display_requestChannelUpdate(Channel *chan);
+void display_showChannel(Channel *chan);
+void display_showProfiler(bool show);
+void display_updateProfiler(void);
+void display_showWriteStats(bool show);
+void display_updateWriteStats(void);
+void display_showEnvelopes(bool show);
+void display_updateEnvelopes(void);
+void display_showLatency(bool show);
+void display_updateLatency(void);
@@ -0,0 +1,677 @@
+#include <dirent.h>
+#include <genesis.h>
+#include <host.h>
+#include <lz.h>
+#include <patch.h>
+#include <preset_bank.h>
+#include <presets.h>
+#include <replay.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define SCENARIO_DIR "tests/scenarios"
+#define GOLDEN_DIR "tests/golden"
+#define BOOT_GOLDEN GOLDEN_DIR "/boot.txt"
+#define MAX_STEPS 512
+#define MAX_SCENARIOS 64
+#define MAX_PATH 256
+#define MAX_LINE 256
+#define BUTTON_LETTERS "UDLRBCASZYXM"
+#define FUZZ_MIN_STEPS 4
+#define FUZZ_MAX_STEPS 32
+#define FUZZ_MAX_HOLD 12
+#define FUZZ_MIDI_CHANNELS 8
+
+/*
+ * Runs the synth against the hardware model in tests/host.c. The synth boots
+ * once; each script then runs in a forked copy of the booted process.
+ *
+ *   harness                 compare every scenario with its golden file
+ *   harness --update        rewrite the golden files
+ *   harness FILE            print the trace of one scenario
+ *   harness --fuzz N [--seed S]
+ *                           run N random scripts twice each, checking that
+ *                           both runs match and that every input replay
+ *                           writes what its recording wrote
+ *   harness --lz PACKED FILE
+ *                           check that lz_read, in reads of varying sizes,
+ *                           decodes PACKED from tools/lzpack back to FILE
+ *   harness --bank FILE     write the presets in presets.h to FILE in the
+ *                           format patch_loadPreset reads, for tools/lzpack
+ *
+ * A scenario is a text file of steps, one per line: "<frames> <buttons>"
+ * holds the buttons (letters from BUTTON_LETTERS, or "-" for none), "midi"
+ * followed by hex bytes sends them to the MIDI port, "inject" feeds them to
+ * midi_inject, "screen" prints the screen, "export" prints the automation
+ * lanes as automation_export writes them and "stats" prints the YM2612 write
+ * statistics. A '#' starts a comment.
+ */
+typedef enum { MODE_GOLDEN, MODE_UPDATE, MODE_SINGLE, MODE_FUZZ, MODE_LZ, MODE_BANK } Mode;
+typedef unsigned long long u64;
+
+static void jobs(void);
+static int runGoldens(bool update);
+static int runFuzz(void);
+static int fuzzWorker(u32 worker, u32 workers);
+static bool run(const Script *script, bool verbose, char **output);
+static bool loadScript(const char *path, Script *script);
+static void randomScript(u64 seed, Script *script);
+static void printScript(const Script *script, FILE *file);
+static u16 parseButtons(const char *text);
+static bool checkFile(const char *path, const char *actual, bool update);
+static char *readFile(FILE *file);
+static u32 nextRandom(u64 *state);
+static void checkReplay(void);
+static int checkLz(const char *packedPath, const char *path);
+static u8 *readBytes(const char *path, long *size);
+static int writeBank(const char *path);
+
+static Mode mode = MODE_GOLDEN;
+static const char *singlePath;
+static const char *packedPath;
+static u32 fuzzCount = 0;
+static u64 fuzzSeed = 1;
+static Step steps[MAX_STEPS];
+static jmp_buf resume;
+
+static ReplayState lastReplayState = REPLAY_IDLE;
+static u16 recordedFrames;
+static u32 recordedMidi;
+static u16 playedFrames;
+
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--update") == 0)
+        {
+            mode = MODE_UPDATE;
+        }
+        else if (strcmp(argv[i], "--fuzz") == 0 && i + 1 < argc)
+        {
+            mode = MODE_FUZZ;
+            fuzzCount = strtoul(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            fuzzSeed = strtoull(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "--lz") == 0 && i + 2 < argc)
+        {
+            mode = MODE_LZ;
+            packedPath = argv[++i];
+            singlePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--bank") == 0 && i + 1 < argc)
+        {
+            mode = MODE_BANK;
+            singlePath = argv[++i];
+        }
+        else if (argv[i][0] != '-')
+        {
+            mode = MODE_SINGLE;
+            singlePath = argv[i];
+        }
+        else
+        {
+            fprintf(stderr,
+                    "usage: %s [--update | FILE | --fuzz N [--seed S] | --lz PACKED FILE | "
+                    "--bank FILE]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (mode == MODE_LZ)
+    {
+        return checkLz(packedPath, singlePath);
+    }
+    host_boot(jobs);
+    return 2;
+}
+
+/*
+ * Called at the end of the first frame, with the synth booted. Script runs
+ * jump back here in the child process and return into the synth main loop.
+ */
+static void jobs(void)
+{
+    if (setjmp(resume) != 0)
+    {
+        return;
+    }
+    fflush(stdout);
+    switch (mode)
+    {
+    case MODE_GOLDEN:
+        exit(runGoldens(false));
+    case MODE_UPDATE:
+        exit(runGoldens(true));
+    case MODE_FUZZ:
+        exit(runFuzz());
+    case MODE_LZ:
+        exit(checkLz(packedPath, singlePath));
+    case MODE_BANK:
+        exit(writeBank(singlePath));
+    case MODE_SINGLE:
+    {
+        Script script;
+        if (!loadScript(singlePath, &script))
+        {
+            exit(2);
+        }
+        fflush(stdout);
+        host_start(&script, stdout, true, checkReplay);
+        return;
+    }
+    }
+}
+
+static int compareNames(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static int runGoldens(bool update)
+{
+    int failures = 0;
+    FILE *bootTrace = tmpfile();
+    host_printBoot(bootTrace);
+    char *boot = readFile(bootTrace);
+    failures += !checkFile(BOOT_GOLDEN, boot, update);
+    free(boot);
+
+    DIR *dir = opendir(SCENARIO_DIR);
+    if (dir == NULL)
+    {
+        perror(SCENARIO_DIR);
+        return 2;
+    }
+    char *names[MAX_SCENARIOS];
+    u16 count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && count < MAX_SCENARIOS)
+    {
+        size_t length = strlen(entry->d_name);
+        if (length > 4 && strcmp(entry->d_name + length - 4, ".txt") == 0)
+        {
+            names[count++] = strdup(entry->d_name);
+        }
+    }
+    closedir(dir);
+    qsort(names, count, sizeof(names[0]), compareNames);
+
+    for (u16 i = 0; i < count; i++)
+    {
+        char path[MAX_PATH];
+        snprintf(path, sizeof(path), SCENARIO_DIR "/%s", names[i]);
+        Script script;
+        char *output = NULL;
+        if (!loadScript(path, &script))
+        {
+            failures++;
+        }
+        else if (!run(&script, true, &output))
+        {
+            printf("FAIL %s\n%s", names[i], output);
+            failures++;
+        }
+        else
+        {
+            snprintf(path, sizeof(path), GOLDEN_DIR "/%s", names[i]);
+            failures += !checkFile(path, output, update);
+        }
+        free(output);
+        free(names[i]);
+    }
+    printf("%u scenarios, %d failed\n", count + 1, failures);
+    return failures == 0 ? 0 : 1;
+}
+
+/* Splits the scripts between one worker per processor */
+static int runFuzz(void)
+{
+    long workers = sysconf(_SC_NPROCESSORS_ONLN);
+    if (workers < 1)
+    {
+        workers = 1;
+    }
+    for (long w = 0; w < workers; w++)
+    {
+        if (fork() == 0)
+        {
+            exit(fuzzWorker(w, workers));
+        }
+    }
+    int failures = 0;
+    int status;
+    while (wait(&status) > 0)
+    {
+        failures += !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+    printf("%u fuzz scripts from seed %llu, %s\n", fuzzCount, fuzzSeed,
+           failures == 0 ? "all passed" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
+
+static int fuzzWorker(u32 worker, u32 workers)
+{
+    for (u32 i = worker; i < fuzzCount; i += workers)
+    {
+        Script script;
+        char *first = NULL;
+        char *second = NULL;
+        randomScript(fuzzSeed + i, &script);
+        bool passed = run(&script, false, &first) && run(&script, false, &second)
+                      && strcmp(first, second) == 0;
+        if (!passed)
+        {
+            flockfile(stdout);
+            printf("FAIL seed %llu\n%s%s", fuzzSeed + i, first, second != NULL ? second : "");
+            printScript(&script, stdout);
+            funlockfile(stdout);
+        }
+        free(first);
+        free(second);
+        if (!passed)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Runs a script in a copy of the booted synth and collects what it printed */
+static bool run(const Script *script, bool verbose, char **output)
+{
+    FILE *file = tmpfile();
+    fflush(stdout);
+    pid_t child = fork();
+    if (child < 0)
+    {
+        perror("fork");
+        exit(2);
+    }
+    if (child == 0)
+    {
+        host_start(script, file, verbose, checkReplay);
+        longjmp(resume, 1);
+    }
+    int status;
+    waitpid(child, &status, 0);
+    *output = readFile(file);
+    fclose(file);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/*
+ * An input replay that runs to the end must write exactly what its recording
+ * wrote, unless MIDI input arrived in the meantime. Recording and playback
+ * both stop tracing at the VBlank after their last frame of input.
+ */
+static void checkReplay(void)
+{
+    ReplayState state = replay_state();
+    if (state == REPLAY_RECORDING)
+    {
+        if (lastReplayState != REPLAY_RECORDING)
+        {
+            recordedFrames = 0;
+            recordedMidi = host_midiActivity();
+        }
+        recordedFrames++;
+    }
+    else if (state == REPLAY_PLAYING)
+    {
+        if (lastReplayState != REPLAY_PLAYING)
+        {
+            playedFrames = 0;
+        }
+        playedFrames++;
+    }
+    else if (lastReplayState == REPLAY_PLAYING && playedFrames == recordedFrames
+             && host_midiActivity() == recordedMidi
+             && (replay_writeCount() != replay_recordedWriteCount()
+                 || replay_signature() != replay_recordedSignature()))
+    {
+        host_fail("replay of %u frames wrote %u/%04X, its recording wrote %u/%04X",
+                  recordedFrames, replay_writeCount(), replay_signature(),
+                  replay_recordedWriteCount(), replay_recordedSignature());
+    }
+    lastReplayState = state;
+}
+
+static bool loadScript(const char *path, Script *script)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        perror(path);
+        return false;
+    }
+    char line[MAX_LINE];
+    u16 count = 0;
+    u16 lineNumber = 0;
+    bool valid = true;
+    while (valid && fgets(line, sizeof(line), file) != NULL)
+    {
+        lineNumber++;
+        char *comment = strchr(line, '#');
+        if (comment != NULL)
+        {
+            *comment = 0;
+        }
+        char *word = strtok(line, " \t\r\n");
+        if (word == NULL)
+        {
+            continue;
+        }
+        if (count == MAX_STEPS)
+        {
+            valid = false;
+            break;
+        }
+        Step *step = &steps[count++];
+        memset(step, 0, sizeof(*step));
+        if (strcmp(word, "screen") == 0)
+        {
+            step->kind = STEP_SCREEN;
+        }
+        else if (strcmp(word, "export") == 0)
+        {
+            step->kind = STEP_EXPORT;
+        }
+        else if (strcmp(word, "stats") == 0)
+        {
+            step->kind = STEP_STATS;
+        }
+        else if (strcmp(word, "midi") == 0 || strcmp(word, "inject") == 0)
+        {
+            step->kind = strcmp(word, "midi") == 0 ? STEP_MIDI : STEP_INJECT;
+            while ((word = strtok(NULL, " \t\r\n")) != NULL && step->length < HOST_MAX_BYTES)
+            {
+                step->bytes[step->length++] = strtoul(word, NULL, 16);
+            }
+        }
+        else
+        {
+            step->kind = STEP_HOLD;
+            step->frames = strtoul(word, NULL, 10);
+            word = strtok(NULL, " \t\r\n");
+            valid = step->frames > 0 && word != NULL;
+            step->buttons = valid ? parseButtons(word) : 0;
+        }
+    }
+    fclose(file);
+    if (!valid)
+    {
+        fprintf(stderr, "%s:%u: bad step\n", path, lineNumber);
+        return false;
+    }
+    script->steps = steps;
+    script->count = count;
+    return true;
+}
+
+/*
+ * Scripts either press buttons, MODE included so input replays get checked,
+ * or play MIDI with the odd button press, as MIDI input would make a replay
+ * differ from its recording.
+ */
+static void randomScript(u64 seed, Script *script)
+{
+    static const u16 BUTTONS[] = {BUTTON_UP, BUTTON_DOWN, BUTTON_LEFT, BUTTON_RIGHT, BUTTON_A,
+                                  BUTTON_B, BUTTON_C, BUTTON_START, BUTTON_X, BUTTON_Y,
+                                  BUTTON_Z, BUTTON_MODE};
+    static const u8 STATUSES[] = {0x80, 0x90, 0x90, 0xB0, 0xE0};
+    u64 state = seed * 0x9E3779B97F4A7C15ull + 1;
+    bool midi = nextRandom(&state) % 2;
+    u16 count = FUZZ_MIN_STEPS + nextRandom(&state) % (FUZZ_MAX_STEPS - FUZZ_MIN_STEPS);
+    for (u16 i = 0; i < count; i++)
+    {
+        Step *step = &steps[i];
+        memset(step, 0, sizeof(*step));
+        u32 kind = nextRandom(&state) % 8;
+        if (midi && kind < 5)
+        {
+            step->kind = kind == 0 ? STEP_INJECT : STEP_MIDI;
+            u8 messages = 1 + nextRandom(&state) % 4;
+            for (u8 m = 0; m < messages; m++)
+            {
+                u8 *bytes = &step->bytes[step->length];
+                bytes[0] = STATUSES[nextRandom(&state) % sizeof(STATUSES)]
+                           | nextRandom(&state) % FUZZ_MIDI_CHANNELS;
+                bytes[1] = nextRandom(&state) % 128;
+                bytes[2] = nextRandom(&state) % 128;
+                step->length += 3;
+            }
+            if (nextRandom(&state) % 8 == 0)
+            {
+                step->bytes[step->length++] = nextRandom(&state);
+            }
+        }
+        else if (kind == 7)
+        {
+            step->kind = nextRandom(&state) % 4 == 0 ? STEP_EXPORT : STEP_SCREEN;
+        }
+        else
+        {
+            step->kind = STEP_HOLD;
+            step->frames = 1 + nextRandom(&state) % FUZZ_MAX_HOLD;
+            u32 pick = nextRandom(&state) % (sizeof(BUTTONS) / sizeof(BUTTONS[0]) + 2);
+            if (pick < sizeof(BUTTONS) / sizeof(BUTTONS[0]))
+            {
+                step->buttons = BUTTONS[pick];
+            }
+            if (nextRandom(&state) % 4 == 0)
+            {
+                step->buttons |= BUTTONS[nextRandom(&state) % 4];
+            }
+            if (midi)
+            {
+                step->buttons &= ~BUTTON_MODE;
+            }
+        }
+    }
+    script->steps = steps;
+    script->count = count;
+}
+
+static void printScript(const Script *script, FILE *file)
+{
+    for (u16 i = 0; i < script->count; i++)
+    {
+        const Step *step = &script->steps[i];
+        if (step->kind == STEP_SCREEN)
+        {
+            fprintf(file, "screen\n");
+        }
+        else if (step->kind == STEP_EXPORT)
+        {
+            fprintf(file, "export\n");
+        }
+        else if (step->kind == STEP_STATS)
+        {
+            fprintf(file, "stats\n");
+        }
+        else if (step->kind == STEP_MIDI || step->kind == STEP_INJECT)
+        {
+            fprintf(file, step->kind == STEP_MIDI ? "midi" : "inject");
+            for (u8 b = 0; b < step->length; b++)
+            {
+                fprintf(file, " %02X", step->bytes[b]);
+            }
+            fprintf(file, "\n");
+        }
+        else
+        {
+            fprintf(file, "%u ", step->frames);
+            for (u8 b = 0; BUTTON_LETTERS[b]; b++)
+            {
+                if (step->buttons & parseButtons((char[]){BUTTON_LETTERS[b], 0}))
+                {
+                    fputc(BUTTON_LETTERS[b], file);
+                }
+            }
+            fprintf(file, step->buttons == 0 ? "-\n" : "\n");
+        }
+    }
+}
+
+static u16 parseButtons(const char *text)
+{
+    static const u16 BUTTONS[] = {BUTTON_UP, BUTTON_DOWN, BUTTON_LEFT, BUTTON_RIGHT,
+                                  BUTTON_B, BUTTON_C, BUTTON_A, BUTTON_START,
+                                  BUTTON_Z, BUTTON_Y, BUTTON_X, BUTTON_MODE};
+    u16 buttons = 0;
+    for (; *text; text++)
+    {
+        const char *letter = strchr(BUTTON_LETTERS, *text);
+        if (letter != NULL)
+        {
+            buttons |= BUTTONS[letter - BUTTON_LETTERS];
+        }
+    }
+    return buttons;
+}
+
+static bool checkFile(const char *path, const char *actual, bool update)
+{
+    if (update)
+    {
+        FILE *file = fopen(path, "w");
+        if (file == NULL)
+        {
+            perror(path);
+            return false;
+        }
+        fputs(actual, file);
+        fclose(file);
+        return true;
+    }
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        printf("FAIL %s: missing, run make test-update\n", path);
+        return false;
+    }
+    char *expected = readFile(file);
+    fclose(file);
+    bool same = strcmp(expected, actual) == 0;
+    if (!same)
+    {
+        u32 line = 1;
+        const char *e = expected;
+        const char *a = actual;
+        while (*e && *e == *a)
+        {
+            line += *e == '\n';
+            e++;
+            a++;
+        }
+        printf("FAIL %s: differs from line %u\n", path, line);
+    }
+    free(expected);
+    return same;
+}
+
+static char *readFile(FILE *file)
+{
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    rewind(file);
+    char *text = malloc(length + 1);
+    length = fread(text, 1, length, file);
+    text[length] = 0;
+    return text;
+}
+
+static int checkLz(const char *packedPath, const char *path)
+{
+    long packedSize;
+    long size;
+    u8 *packed = readBytes(packedPath, &packedSize);
+    u8 *expected = readBytes(path, &size);
+    if (packed == NULL || expected == NULL || packedSize < LZ_HEADER_SIZE)
+    {
+        return 2;
+    }
+    static LzStream stream;
+    lz_open(&stream, packed);
+    if (lz_remaining(&stream) != (u32)size)
+    {
+        fprintf(stderr, "FAIL %s: header says %u bytes, expected %ld\n", packedPath,
+                lz_remaining(&stream), size);
+        return 1;
+    }
+    long position = 0;
+    for (u16 count = 1; !lz_done(&stream); count = count % 13 + 1)
+    {
+        u8 chunk[13];
+        u16 read = lz_read(&stream, chunk, count);
+        if (read == 0 || position + read > size || memcmp(chunk, expected + position, read) != 0)
+        {
+            fprintf(stderr, "FAIL %s: decodes differently from %s at byte %ld\n", packedPath, path,
+                    position);
+            return 1;
+        }
+        position += read;
+    }
+    if (position != size)
+    {
+        fprintf(stderr, "FAIL %s: decoded %ld of %ld bytes\n", packedPath, position, size);
+        return 1;
+    }
+    printf("%s: %ld bytes packed to %ld\n", path, size, packedSize);
+    return 0;
+}
+
+static u8 *readBytes(const char *path, long *size)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        perror(path);
+        return NULL;
+    }
+    u8 *data = (u8 *)readFile(file);
+    fseek(file, 0, SEEK_END);
+    *size = ftell(file);
+    fclose(file);
+    return data;
+}
+
+static u32 nextRandom(u64 *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state >> 32;
+}
+
+static int writeBank(const char *path)
+{
+    static const Preset *const presets[PRESET_BANK_COUNT] = {
+        [PRESET_CASTLEVANIA_NUMBER] = &PRESET_CASTLEVANIA};
+    FILE *file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        perror(path);
+        return 2;
+    }
+    u8 data[PATCH_CHANNEL_SIZE];
+    for (u16 p = 0; p < PRESET_BANK_COUNT; p++)
+    {
+        synth_preset(presets[p]);
+        patch_packGlobals(data);
+        fwrite(data, 1, PATCH_GLOBALS_SIZE, file);
+        for (u8 c = 0; c < CHANNEL_COUNT; c++)
+        {
+            patch_packChannel(synth_channel(c), data);
+            fwrite(data, 1, PATCH_CHANNEL_SIZE, file);
+        }
+    }
+    fclose(file);
+    return 0;
+}
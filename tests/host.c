@@ -0,0 +1,887 @@
+#include <automation.h>
+#include <genesis.h>
+#include <host.h>
+#include <midi.h>
+#include <megadrive.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define LINE_UNITS 256
+#define FRAME_LINES 262
+#define ACTIVE_LINES 224
+#define VINT_LINE 224
+#define V_COUNTER_JUMP_LINE 0xEB
+#define V_COUNTER_JUMP_VALUE 0xE5
+#define H_COUNTER_STEPS 210
+#define H_COUNTER_JUMP_STEP 0xB7
+#define H_COUNTER_JUMP_VALUE 0xE4
+#define H_COUNTER_LINE_START 0xA5
+
+#define YM_WRITE_UNITS 32
+#define YM_BUSY_UNITS 8
+#define YM_STATUS_UNITS 1
+#define VRAM_WRITE_UNITS 4
+#define HV_COUNTER_UNITS 32
+#define TIMER_A_UNITS(value) ((1024 - (value)) * 756 / 10)
+#define TIMER_A_LOAD 0x01
+#define TIMER_A_ENABLE 0x04
+#define TIMER_A_RESET 0x10
+#define TIMER_A_OVERFLOW 0x01
+#define YM_BUSY 0x80
+
+#define PORT2_RX_DATA 0xA10017
+#define PORT2_SERIAL_CTRL 0xA10019
+#define SERIAL_IN 0x20
+#define SERIAL_RX_INT 0x08
+#define SERIAL_RX_ERROR 0x04
+#define SERIAL_RX_READY 0x02
+#define SERIAL_BYTE_UNITS 8391
+#define SERIAL_QUEUE_SIZE 256
+
+#define VDP_REG_COUNT 24
+#define VDP_MODE_REG_3 11
+#define VDP_EXT_INT_ENABLE 0x08
+#define VRAM_SIZE 0x10000
+#define WINDOW_WIDTH 64
+#define PLANE_ROWS 32
+#define SCREEN_WIDTH 40
+#define SCREEN_HEIGHT 28
+#define FONT_LENGTH 96
+#define METER_TILES 9
+#define FPS 60
+
+#define SRAM_SIZE 0x10000
+#define MAX_FRAME_WRITES 4096
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME 16777619u
+
+/*
+ * A model of the parts of the Mega Drive the synth touches, driven a frame
+ * at a time by a script. Time is counted in 1/256ths of an NTSC scanline.
+ * It passes while the main loop waits for VBlank, and also for each YM2612
+ * register write, VRAM word and character drawn, so interrupts land part
+ * way through main loop work as they would on the console. Every YM2612
+ * write is checked and traced; the trace and screens printed by the script
+ * are folded into an FNV-1a hash so two runs can be compared cheaply.
+ */
+typedef unsigned long long Time;
+
+typedef struct
+{
+    u8 part;
+    u8 reg;
+    u8 data;
+} Write;
+
+static void advance(Time units);
+static void startLine(u16 line);
+static void updateTimer(void);
+static void receiveSerial(void);
+static void deliverInterrupts(void);
+static void interrupt(void (*callback)(void));
+static void checkWrite(u8 part, u8 reg, u8 data);
+static bool validRegister(u8 part, u8 reg);
+static void writeTimer(u8 reg, u8 data);
+static void writeVram(u16 address, u16 value);
+static u16 *planeCell(VDPPlane plane, u16 x, u16 y);
+static void runSteps(void);
+static void sendSerial(const u8 *bytes, u8 length);
+static void finish(void);
+static void printWrites(void);
+static void printWriteStats(void);
+static void printAutomation(void);
+static void printScreen(void);
+static char cellChar(u16 tile);
+static void emit(const char *format, ...);
+
+vu32 vtimer = 0;
+
+static Time now = 0;
+static Time linesStarted = 0;
+static u16 maskLevel = 3;
+static u16 disableDepth = 0;
+static bool inInterrupt = false;
+static bool vintPending = false;
+static bool hintPending = false;
+static bool extPending = false;
+static void (*vintCallback)(void) = NULL;
+static void (*hintCallback)(void) = NULL;
+static void (*extCallback)(void) = NULL;
+
+static u8 vdpRegs[VDP_REG_COUNT];
+static u16 vram[VRAM_SIZE / 2];
+static u16 vramAddress = 0;
+static u16 windowMap[PLANE_ROWS][WINDOW_WIDTH];
+static u16 planeAAddress = 0xC000;
+static u16 planeBAddress = 0xE000;
+static u16 planeWidth = 64;
+static s16 hscrollA = 0;
+static bool windowDown = false;
+static u16 windowRow = 0;
+static u16 textPalette = PAL0;
+static u8 hintReload = 0xFF;
+static u8 hintCounter = 0xFF;
+static bool hintEnabled = false;
+
+static u8 ymRegisters[2][256];
+static Time ymBusyUntil = 0;
+static u8 ymFlags = 0;
+static u16 timerA = 0;
+static bool timerALoaded = false;
+static bool timerAEnabled = false;
+static Time timerANext = 0;
+static s16 frequencyLatch = -1;
+static s16 ch3FrequencyLatch = -1;
+static Write writes[MAX_FRAME_WRITES];
+static u16 writeCount = 0;
+
+static u8 serialCtrl = 0;
+static u8 rxData = 0;
+static bool rxReady = false;
+static bool rxError = false;
+static u8 serialBytes[SERIAL_QUEUE_SIZE];
+static Time serialTimes[SERIAL_QUEUE_SIZE];
+static u8 serialHead = 0;
+static u8 serialTail = 0;
+static u32 midiActivity = 0;
+
+/* JOY_readJoypad returns what the last JOY_update latched, as on SGDK */
+static u16 padState = 0;
+static u16 padCache = 0;
+
+static u8 sram[SRAM_SIZE];
+static bool sramEnabled = false;
+static bool sramWritable = false;
+
+static HostJobs jobs = NULL;
+static Script script;
+static bool started = false;
+static HostFrameHook frameHook = NULL;
+static u16 stepIndex = 0;
+static u16 holdFrames = 0;
+static FILE *out = NULL;
+static bool verbose = false;
+static u32 hash = FNV_OFFSET;
+
+void host_boot(HostJobs hostJobs)
+{
+    jobs = hostJobs;
+    synth_main();
+}
+
+void host_start(const Script *hostScript, FILE *file, bool printTrace, HostFrameHook hook)
+{
+    script = *hostScript;
+    started = true;
+    out = file;
+    verbose = printTrace;
+    frameHook = hook;
+    writeCount = 0;
+}
+
+void host_printBoot(FILE *file)
+{
+    out = file;
+    verbose = true;
+    printWrites();
+    printScreen();
+    fflush(out);
+    out = NULL;
+}
+
+void host_fail(const char *format, ...)
+{
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    FILE *file = out != NULL ? out : stderr;
+    fprintf(file, "fail at frame %u: %s\n", vtimer, text);
+    fflush(file);
+    _exit(2);
+}
+
+u32 host_midiActivity(void) { return midiActivity; }
+
+u8 host_vCounter(void)
+{
+    u16 line = (now / LINE_UNITS) % FRAME_LINES;
+    return line < V_COUNTER_JUMP_LINE ? line : line - V_COUNTER_JUMP_LINE + V_COUNTER_JUMP_VALUE;
+}
+
+u16 host_hvCounter(void)
+{
+    advance(HV_COUNTER_UNITS);
+    u16 step = ((now % LINE_UNITS) * H_COUNTER_STEPS / LINE_UNITS + H_COUNTER_LINE_START)
+               % H_COUNTER_STEPS;
+    u8 h = step < H_COUNTER_JUMP_STEP ? step : step - H_COUNTER_JUMP_STEP + H_COUNTER_JUMP_VALUE;
+    return (host_vCounter() << 8) | h;
+}
+
+u8 host_portRead(u32 address)
+{
+    switch (address)
+    {
+    case YM2612_BASEPORT:
+        advance(YM_STATUS_UNITS);
+        updateTimer();
+        return (now < ymBusyUntil ? YM_BUSY : 0) | ymFlags;
+    case PORT2_SERIAL_CTRL:
+        return serialCtrl | (rxError ? SERIAL_RX_ERROR : 0) | (rxReady ? SERIAL_RX_READY : 0);
+    case PORT2_RX_DATA:
+        rxReady = false;
+        rxError = false;
+        return rxData;
+    default:
+        host_fail("read from unmodelled port %06X", address);
+        return 0;
+    }
+}
+
+void host_portWrite(u32 address, u32 value, u8 size)
+{
+    if (address == GFX_CTRL_PORT && size == 4)
+    {
+        if ((value & 0xC00000F0) != 0x40000000)
+        {
+            host_fail("unsupported VDP command %08X", value);
+        }
+        vramAddress = ((value >> 16) & 0x3FFF) | ((value & 3) << 14);
+    }
+    else if (address == GFX_DATA_PORT && size == 2)
+    {
+        writeVram(vramAddress, value);
+        vramAddress += 2;
+        advance(VRAM_WRITE_UNITS);
+    }
+    else if (address == PORT2_SERIAL_CTRL && size == 1)
+    {
+        serialCtrl = value & 0xF8;
+    }
+    else
+    {
+        host_fail("%u byte write to unmodelled port %06X", size, address);
+    }
+}
+
+/* SGDK */
+
+void SYS_doVBlankProcess(void)
+{
+    if (disableDepth != 0)
+    {
+        host_fail("interrupts still disabled at the end of the frame");
+    }
+    if (!started)
+    {
+        jobs();
+    }
+    printWrites();
+    if (frameHook != NULL)
+    {
+        frameHook();
+    }
+    runSteps();
+    u32 frame = vtimer;
+    while (vtimer == frame)
+    {
+        advance(LINE_UNITS - now % LINE_UNITS);
+    }
+}
+
+void SYS_disableInts(void)
+{
+    if (!inInterrupt)
+    {
+        disableDepth++;
+    }
+}
+
+void SYS_enableInts(void)
+{
+    if (inInterrupt)
+    {
+        return;
+    }
+    if (disableDepth == 0)
+    {
+        host_fail("SYS_enableInts without SYS_disableInts");
+    }
+    if (--disableDepth == 0)
+    {
+        deliverInterrupts();
+    }
+}
+
+void SYS_setInterruptMaskLevel(u16 value)
+{
+    maskLevel = value;
+    deliverInterrupts();
+}
+
+void SYS_setVIntCallback(void (*callback)(void)) { vintCallback = callback; }
+
+void SYS_setHIntCallback(void (*callback)(void)) { hintCallback = callback; }
+
+void SYS_setExtIntCallback(void (*callback)(void)) { extCallback = callback; }
+
+u16 SYS_isPAL(void) { return FALSE; }
+
+void VDP_setPaletteColor(u16 index, u16 value) {}
+
+void VDP_setTextPalette(u16 palette) { textPalette = palette; }
+
+void VDP_drawTextBG(VDPPlane plane, const char *str, u16 x, u16 y)
+{
+    while (*str)
+    {
+        u16 *cell = planeCell(plane, x++, y);
+        if (cell != NULL)
+        {
+            *cell = TILE_ATTR_FULL(textPalette, FALSE, FALSE, FALSE, TILE_FONTINDEX + *str - 32);
+        }
+        str++;
+        advance(VRAM_WRITE_UNITS);
+    }
+}
+
+void VDP_clearPlane(VDPPlane plane, bool wait)
+{
+    for (u16 y = 0; y < PLANE_ROWS; y++)
+    {
+        for (u16 x = 0; x < (plane == WINDOW ? WINDOW_WIDTH : planeWidth); x++)
+        {
+            *planeCell(plane, x, y) = 0;
+        }
+    }
+}
+
+void VDP_setTileMapXY(VDPPlane plane, u16 tile, u16 x, u16 y)
+{
+    u16 *cell = planeCell(plane, x, y);
+    if (cell == NULL)
+    {
+        host_fail("tile written outside the plane at %u,%u", x, y);
+    }
+    *cell = tile;
+    advance(VRAM_WRITE_UNITS);
+}
+
+void VDP_loadTileData(const u32 *data, u16 index, u16 num, TransferMethod tm)
+{
+    if (index + num > TILE_FONTINDEX)
+    {
+        host_fail("tiles %u-%u overwrite the font", index, index + num - 1);
+    }
+}
+
+void VDP_setPlaneSize(u16 w, u16 h, bool setupVram) { planeWidth = w; }
+
+void VDP_setBGAAddress(u16 value) { planeAAddress = value; }
+
+void VDP_setBGBAddress(u16 value) { planeBAddress = value; }
+
+void VDP_setHorizontalScroll(VDPPlane plane, s16 value)
+{
+    if (plane == BG_A)
+    {
+        hscrollA = value;
+    }
+}
+
+void VDP_setWindowVPos(u16 down, u16 pos)
+{
+    windowDown = down;
+    windowRow = pos;
+}
+
+u8 VDP_getReg(u16 reg) { return vdpRegs[reg]; }
+
+void VDP_setReg(u16 reg, u8 value) { vdpRegs[reg] = value; }
+
+void VDP_setHIntCounter(u8 value) { hintReload = value; }
+
+void VDP_setHInterrupt(u8 value) { hintEnabled = value; }
+
+u32 SYS_getFPS(void) { return FPS; }
+
+void JOY_update(void) { padCache = padState; }
+
+u16 JOY_readJoypad(u16 joy) { return joy == JOY_1 ? padCache : 0; }
+
+void YM2612_writeReg(const u16 part, const u8 reg, const u8 data)
+{
+    checkWrite(part, reg, data);
+    if (writeCount == MAX_FRAME_WRITES)
+    {
+        host_fail("more than %u YM2612 writes in a frame", MAX_FRAME_WRITES);
+    }
+    writes[writeCount++] = (Write){part, reg, data};
+    ymRegisters[part][reg] = data;
+    if (part == 0)
+    {
+        writeTimer(reg, data);
+    }
+    advance(YM_WRITE_UNITS);
+    ymBusyUntil = now + YM_BUSY_UNITS;
+}
+
+void Z80_requestBus(u16 wait) {}
+
+void SRAM_enable(void)
+{
+    sramEnabled = true;
+    sramWritable = true;
+}
+
+void SRAM_enableRO(void)
+{
+    sramEnabled = true;
+    sramWritable = false;
+}
+
+void SRAM_disable(void)
+{
+    sramEnabled = false;
+    sramWritable = false;
+}
+
+u8 SRAM_readByte(u32 offset)
+{
+    if (!sramEnabled || offset >= SRAM_SIZE)
+    {
+        host_fail("SRAM read at %X while %s", offset, sramEnabled ? "enabled" : "disabled");
+    }
+    return sram[offset];
+}
+
+void SRAM_writeByte(u32 offset, u8 value)
+{
+    if (!sramWritable || offset >= SRAM_SIZE)
+    {
+        host_fail("SRAM write at %X while not writable", offset);
+    }
+    sram[offset] = value;
+}
+
+u32 uintToStr(u32 value, char *str, u16 minsize)
+{
+    return sprintf(str, "%0*u", minsize, value);
+}
+
+/* Time and interrupts */
+
+static void advance(Time units)
+{
+    Time end = now + units;
+    bool serialDue = serialHead != serialTail && serialTimes[serialHead] <= end;
+    if (end / LINE_UNITS == now / LINE_UNITS && !serialDue)
+    {
+        /* Nothing can happen within a line but a timer overflow, read with the status */
+        now = end;
+        return;
+    }
+    while (now < end)
+    {
+        Time nextLine = (now / LINE_UNITS + 1) * LINE_UNITS;
+        now = nextLine < end ? nextLine : end;
+        updateTimer();
+        receiveSerial();
+        while (linesStarted < now / LINE_UNITS)
+        {
+            linesStarted++;
+            startLine(linesStarted % FRAME_LINES);
+        }
+        deliverInterrupts();
+    }
+}
+
+static void startLine(u16 line)
+{
+    if (line < ACTIVE_LINES)
+    {
+        if (hintCounter-- == 0)
+        {
+            hintCounter = hintReload;
+            hintPending |= hintEnabled;
+        }
+    }
+    else
+    {
+        hintCounter = hintReload;
+    }
+    if (line == VINT_LINE)
+    {
+        vintPending = true;
+    }
+}
+
+static void updateTimer(void)
+{
+    while (timerALoaded && now >= timerANext)
+    {
+        if (timerAEnabled)
+        {
+            ymFlags |= TIMER_A_OVERFLOW;
+        }
+        timerANext += TIMER_A_UNITS(timerA);
+    }
+}
+
+static void receiveSerial(void)
+{
+    while (serialHead != serialTail && now >= serialTimes[serialHead])
+    {
+        u8 byte = serialBytes[serialHead++];
+        midiActivity++;
+        if (!(serialCtrl & SERIAL_IN))
+        {
+            continue;
+        }
+        if (rxReady)
+        {
+            rxError = true;
+        }
+        else
+        {
+            rxData = byte;
+            rxReady = true;
+        }
+        if ((serialCtrl & SERIAL_RX_INT) && (vdpRegs[VDP_MODE_REG_3] & VDP_EXT_INT_ENABLE))
+        {
+            extPending = true;
+        }
+    }
+}
+
+static void deliverInterrupts(void)
+{
+    while (disableDepth == 0 && !inInterrupt)
+    {
+        if (vintPending && maskLevel < 6)
+        {
+            vintPending = false;
+            vtimer++;
+            interrupt(vintCallback);
+        }
+        else if (hintPending && maskLevel < 4)
+        {
+            hintPending = false;
+            interrupt(hintCallback);
+        }
+        else if (extPending && maskLevel < 2)
+        {
+            extPending = false;
+            interrupt(extCallback);
+        }
+        else
+        {
+            return;
+        }
+    }
+}
+
+static void interrupt(void (*callback)(void))
+{
+    inInterrupt = true;
+    if (callback != NULL)
+    {
+        callback();
+    }
+    inInterrupt = false;
+}
+
+/* YM2612 */
+
+/*
+ * Registers must exist on the part they are written to, key codes must name
+ * a channel, and each frequency low byte must follow the high byte of the
+ * same channel, as the high byte is held in a latch shared by all channels.
+ */
+static void checkWrite(u8 part, u8 reg, u8 data)
+{
+    if (!validRegister(part, reg))
+    {
+        host_fail("write to missing register %u:%02X", part, reg);
+    }
+    if (reg == 0x28 && (data & 3) == 3)
+    {
+        host_fail("key on/off for missing channel code %02X", data);
+    }
+    u16 latchId = (part << 8) | reg;
+    if (reg >= 0xA4 && reg <= 0xA6)
+    {
+        frequencyLatch = latchId;
+    }
+    else if (reg >= 0xAC && reg <= 0xAE)
+    {
+        ch3FrequencyLatch = latchId;
+    }
+    else if (reg >= 0xA0 && reg <= 0xA2)
+    {
+        if (frequencyLatch != latchId + 4)
+        {
+            host_fail("%u:%02X written without its high byte", part, reg);
+        }
+        frequencyLatch = -1;
+    }
+    else if (reg >= 0xA8 && reg <= 0xAA)
+    {
+        if (ch3FrequencyLatch != latchId + 4)
+        {
+            host_fail("%u:%02X written without its high byte", part, reg);
+        }
+        ch3FrequencyLatch = -1;
+    }
+}
+
+static bool validRegister(u8 part, u8 reg)
+{
+    if (reg < 0x30)
+    {
+        return part == 0 && (reg == 0x22 || (reg >= 0x24 && reg <= 0x28) || reg == 0x2A
+                             || reg == 0x2B);
+    }
+    if (reg >= 0xA8 && reg < 0xB0)
+    {
+        return part == 0 && (reg & 3) != 3;
+    }
+    return reg <= 0xB6 && (reg & 3) != 3;
+}
+
+static void writeTimer(u8 reg, u8 data)
+{
+    if (reg == 0x24)
+    {
+        timerA = (timerA & 3) | (data << 2);
+    }
+    else if (reg == 0x25)
+    {
+        timerA = (timerA & ~3) | (data & 3);
+    }
+    else if (reg == 0x27)
+    {
+        bool load = data & TIMER_A_LOAD;
+        if (load && !timerALoaded)
+        {
+            timerANext = now + TIMER_A_UNITS(timerA);
+        }
+        timerALoaded = load;
+        timerAEnabled = data & TIMER_A_ENABLE;
+        if (data & TIMER_A_RESET)
+        {
+            ymFlags &= ~TIMER_A_OVERFLOW;
+        }
+    }
+}
+
+/* VDP */
+
+static void writeVram(u16 address, u16 value)
+{
+    if (address & 1)
+    {
+        host_fail("odd VRAM address %04X", address);
+    }
+    if ((address >= TILE_USERINDEX * 32 && address < (TILE_USERINDEX + METER_TILES) * 32)
+        || (address >= TILE_FONTINDEX * 32 && address < (TILE_FONTINDEX + FONT_LENGTH) * 32))
+    {
+        host_fail("plane data written over tiles at %04X", address);
+    }
+    vram[address >> 1] = value;
+}
+
+static u16 *planeCell(VDPPlane plane, u16 x, u16 y)
+{
+    if (plane == WINDOW)
+    {
+        return x < WINDOW_WIDTH && y < PLANE_ROWS ? &windowMap[y][x] : NULL;
+    }
+    if (x >= planeWidth || y >= PLANE_ROWS)
+    {
+        return NULL;
+    }
+    u16 address = (plane == BG_A ? planeAAddress : planeBAddress) + (y * planeWidth + x) * 2;
+    return &vram[address >> 1];
+}
+
+/* Scripts */
+
+static void runSteps(void)
+{
+    while (holdFrames == 0)
+    {
+        if (stepIndex == script.count)
+        {
+            finish();
+        }
+        const Step *step = &script.steps[stepIndex++];
+        switch (step->kind)
+        {
+        case STEP_HOLD:
+            padState = step->buttons;
+            holdFrames = step->frames;
+            break;
+        case STEP_MIDI:
+            sendSerial(step->bytes, step->length);
+            break;
+        case STEP_INJECT:
+            for (u8 i = 0; i < step->length; i++)
+            {
+                midi_inject(step->bytes[i]);
+            }
+            midiActivity += step->length;
+            break;
+        case STEP_SCREEN:
+            printScreen();
+            break;
+        case STEP_EXPORT:
+            printAutomation();
+            break;
+        case STEP_STATS:
+            printWriteStats();
+            break;
+        }
+    }
+    holdFrames--;
+}
+
+static void sendSerial(const u8 *bytes, u8 length)
+{
+    Time arrival = now;
+    if (serialHead != serialTail && serialTimes[(u8)(serialTail - 1)] > arrival)
+    {
+        arrival = serialTimes[(u8)(serialTail - 1)];
+    }
+    for (u8 i = 0; i < length; i++)
+    {
+        if ((u8)(serialTail + 1) == serialHead)
+        {
+            host_fail("MIDI script queue full");
+        }
+        arrival += SERIAL_BYTE_UNITS;
+        serialBytes[serialTail] = bytes[i];
+        serialTimes[serialTail++] = arrival;
+    }
+}
+
+static void finish(void)
+{
+    if (!verbose)
+    {
+        fprintf(out, "%08X\n", hash);
+    }
+    fflush(out);
+    _exit(0);
+}
+
+static void printWrites(void)
+{
+    if (writeCount == 0)
+    {
+        return;
+    }
+    emit("%5u", vtimer);
+    for (u16 i = 0; i < writeCount; i++)
+    {
+        if (i != 0 && i % 12 == 0)
+        {
+            emit("\n     ");
+        }
+        emit(" %u:%02X=%02X", writes[i].part, writes[i].reg, writes[i].data);
+    }
+    emit("\n");
+    writeCount = 0;
+}
+
+/* Prints what automation_export writes, 32 bytes to a line */
+static void printAutomation(void)
+{
+    static u8 buffer[1 + AUTOMATION_LANE_COUNT * 6 + AUTOMATION_POOL_SIZE];
+    u16 size = automation_export(buffer, sizeof(buffer));
+    emit("automation at frame %u, %u bytes\n", vtimer, size);
+    for (u16 i = 0; i < size; i++)
+    {
+        emit(i % 32 == 0 ? "  %02X" : i % 32 == 31 || i == size - 1 ? " %02X\n" : " %02X",
+             buffer[i]);
+    }
+}
+
+/* Prints the YM2612 write statistics gathered since they were last cleared */
+static void printWriteStats(void)
+{
+    const WriteStats *stats = megadrive_writeStats();
+    emit("write stats at frame %u, %u requests, %u writes\n", vtimer, stats->requests,
+         stats->writes);
+}
+
+/*
+ * Prints the 40x28 cells on screen, composed from plane A and the window,
+ * followed by the palette of each cell.
+ */
+static void printScreen(void)
+{
+    emit("screen at frame %u\n", vtimer);
+    for (u16 y = 0; y < SCREEN_HEIGHT; y++)
+    {
+        bool inWindow = windowDown ? y >= windowRow : y < windowRow;
+        char text[SCREEN_WIDTH + 1];
+        char palettes[SCREEN_WIDTH + 1];
+        for (u16 x = 0; x < SCREEN_WIDTH; x++)
+        {
+            u16 tile;
+            if (inWindow)
+            {
+                tile = windowMap[y][x];
+            }
+            else
+            {
+                u16 column = ((x * 8 - hscrollA) >> 3) & (planeWidth - 1);
+                tile = *planeCell(BG_A, column, y);
+            }
+            text[x] = cellChar(tile);
+            palettes[x] = '0' + ((tile >> 13) & 3);
+        }
+        text[SCREEN_WIDTH] = 0;
+        palettes[SCREEN_WIDTH] = 0;
+        emit("|%s| %s\n", text, palettes);
+    }
+}
+
+/* Font tiles print as their character and meter tiles as their height */
+static char cellChar(u16 tile)
+{
+    u16 index = tile & 0x7FF;
+    if (index == 0)
+    {
+        return ' ';
+    }
+    if (index >= TILE_FONTINDEX && index < TILE_FONTINDEX + FONT_LENGTH)
+    {
+        return index - TILE_FONTINDEX + 32;
+    }
+    if (index >= TILE_USERINDEX && index < TILE_USERINDEX + METER_TILES)
+    {
+        return '0' + index - TILE_USERINDEX;
+    }
+    return '?';
+}
+
+static void emit(const char *format, ...)
+{
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    for (int i = 0; i < length; i++)
+    {
+        hash = (hash ^ (u8)text[i]) * FNV_PRIME;
+    }
+    if (verbose)
+    {
+        fputs(text, out);
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <genesis.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#define HOST_MAX_BYTES 32
+
+/*
+ * A script is a list of steps run at frame boundaries: hold buttons for a
+ * number of frames, send bytes to the MIDI port, inject them with
+ * midi_inject, print the screen, print the exported automation lanes, or print
+ * the YM2612 write statistics.
+ */
+typedef enum { STEP_HOLD, STEP_MIDI, STEP_INJECT, STEP_SCREEN, STEP_EXPORT, STEP_STATS } StepKind;
+
+typedef struct
+{
+    StepKind kind;
+    u16 frames;
+    u16 buttons;
+    u8 length;
+    u8 bytes[HOST_MAX_BYTES];
+} Step;
+
+typedef struct
+{
+    const Step *steps;
+    u16 count;
+} Script;
+
+typedef void (*HostJobs)(void);
+typedef void (*HostFrameHook)(void);
+
+int synth_main(void);
+
+void host_boot(HostJobs jobs);
+void host_start(const Script *script, FILE *out, bool verbose, HostFrameHook hook);
+void host_printBoot(FILE *out);
+void host_fail(const char *format, ...);
+u32 host_midiActivity(void);
@@ -0,0 +1,107 @@
+#pragma once
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * The parts of SGDK the synth uses, for building it with the host compiler.
+ * Types and constants match SGDK; the functions are implemented by
+ * tests/host.c against a model of the VDP, YM2612, joypad and SRAM.
+ */
+typedef unsigned char u8;
+typedef signed char s8;
+typedef unsigned short u16;
+typedef signed short s16;
+typedef unsigned int u32;
+typedef signed int s32;
+typedef volatile u8 vu8;
+typedef volatile u16 vu16;
+typedef volatile u32 vu32;
+
+#define TRUE 1
+#define FALSE 0
+
+typedef enum { BG_A, BG_B, WINDOW } VDPPlane;
+typedef enum { CPU, DMA, DMA_QUEUE, DMA_QUEUE_COPY } TransferMethod;
+
+#define PAL0 0
+#define PAL1 1
+#define PAL2 2
+#define PAL3 3
+
+#define TILE_USERINDEX 16
+#define TILE_FONTINDEX 1312
+#define TILE_ATTR_FULL(pal, prio, flipV, flipH, index)                                     \
+    ((((u16)(prio)) << 15) | (((u16)(pal)) << 13) | (((u16)(flipV)) << 12)                 \
+     | (((u16)(flipH)) << 11) | ((u16)(index)))
+
+#define GFX_DATA_PORT 0xC00000
+#define GFX_CTRL_PORT 0xC00004
+#define GFX_WRITE_VRAM_ADDR(adr) (((0x4000 + ((adr) & 0x3FFF)) << 16) + (((adr) >> 14) | 0x00))
+#define GET_VCOUNTER host_vCounter()
+#define GET_HVCOUNTER host_hvCounter()
+
+#define YM2612_BASEPORT 0xA04000
+
+#define JOY_1 0
+#define JOY_2 1
+#define BUTTON_UP 0x0001
+#define BUTTON_DOWN 0x0002
+#define BUTTON_LEFT 0x0004
+#define BUTTON_RIGHT 0x0008
+#define BUTTON_B 0x0010
+#define BUTTON_C 0x0020
+#define BUTTON_A 0x0040
+#define BUTTON_START 0x0080
+#define BUTTON_Z 0x0100
+#define BUTTON_Y 0x0200
+#define BUTTON_X 0x0400
+#define BUTTON_MODE 0x0800
+
+#define min(x, y) (((x) < (y)) ? (x) : (y))
+#define max(x, y) (((x) > (y)) ? (x) : (y))
+
+extern vu32 vtimer;
+
+u8 host_vCounter(void);
+u16 host_hvCounter(void);
+
+void SYS_doVBlankProcess(void);
+void SYS_disableInts(void);
+void SYS_enableInts(void);
+void SYS_setInterruptMaskLevel(u16 value);
+void SYS_setVIntCallback(void (*callback)(void));
+void SYS_setHIntCallback(void (*callback)(void));
+void SYS_setExtIntCallback(void (*callback)(void));
+u16 SYS_isPAL(void);
+
+void VDP_setPaletteColor(u16 index, u16 value);
+void VDP_setTextPalette(u16 palette);
+void VDP_drawTextBG(VDPPlane plane, const char *str, u16 x, u16 y);
+void VDP_clearPlane(VDPPlane plane, bool wait);
+void VDP_setTileMapXY(VDPPlane plane, u16 tile, u16 x, u16 y);
+void VDP_loadTileData(const u32 *data, u16 index, u16 num, TransferMethod tm);
+void VDP_setPlaneSize(u16 w, u16 h, bool setupVram);
+void VDP_setBGAAddress(u16 value);
+void VDP_setBGBAddress(u16 value);
+void VDP_setHorizontalScroll(VDPPlane plane, s16 value);
+void VDP_setWindowVPos(u16 down, u16 pos);
+u8 VDP_getReg(u16 reg);
+void VDP_setReg(u16 reg, u8 value);
+void VDP_setHIntCounter(u8 value);
+void VDP_setHInterrupt(u8 value);
+u32 SYS_getFPS(void);
+
+void JOY_update(void);
+u16 JOY_readJoypad(u16 joy);
+
+void YM2612_writeReg(const u16 part, const u8 reg, const u8 data);
+void Z80_requestBus(u16 wait);
+
+void SRAM_enable(void);
+void SRAM_enableRO(void);
+void SRAM_disable(void);
+u8 SRAM_readByte(u32 offset);
+void SRAM_writeByte(u32 offset, u8 value);
+
+u32 uintToStr(u32 value, char *str, u16 minsize);
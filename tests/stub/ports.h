@@ -0,0 +1,11 @@
+#pragma once
+#include <genesis.h>
+
+/* Host stand-in for src/ports.h: port accesses go to the hardware model */
+u8 host_portRead(u32 address);
+void host_portWrite(u32 address, u32 value, u8 size);
+
+#define PORT_READ_U8(address) host_portRead(address)
+#define PORT_WRITE_U8(address, value) host_portWrite((address), (value), 1)
+#define PORT_WRITE_U16(address, value) host_portWrite((address), (value), 2)
+#define PORT_WRITE_U32(address, value) host_portWrite((address), (value), 4)
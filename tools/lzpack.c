@@ -0,0 +1,173 @@
+/*
+ * Host tool: packs a file into the LZSS format read by src/lz.c.
+ *   lzpack <input> <output>
+ *   lzpack -c NAME <input> <output>   write a C array named NAME instead
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WINDOW_SIZE 256
+#define MIN_MATCH 3
+#define MAX_MATCH (255 + MIN_MATCH)
+#define HEADER_SIZE 4
+#define BYTES_PER_LINE 12
+
+static unsigned char *readFile(const char *path, long *size);
+static long pack(const unsigned char *data, long size, unsigned char *packed);
+static void findMatch(const unsigned char *data, long size, long position, int *distance,
+    int *length);
+static void writeArray(FILE *out, const char *name, const unsigned char *packed, long size);
+
+int main(int argc, char **argv)
+{
+    const char *name = NULL;
+    if (argc == 5 && strcmp(argv[1], "-c") == 0)
+    {
+        name = argv[2];
+        argv += 2;
+        argc -= 2;
+    }
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s [-c NAME] <input> <output>\n", argv[0]);
+        return 1;
+    }
+    long size;
+    unsigned char *data = readFile(argv[1], &size);
+    if (data == NULL)
+    {
+        return 1;
+    }
+    unsigned char *packed = malloc(HEADER_SIZE + size + size / 8 + 1);
+    if (packed == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        free(data);
+        return 1;
+    }
+    long packedSize = pack(data, size, packed);
+    FILE *out = fopen(argv[2], name != NULL ? "w" : "wb");
+    if (out == NULL)
+    {
+        perror(argv[2]);
+        free(packed);
+        free(data);
+        return 1;
+    }
+    if (name != NULL)
+    {
+        writeArray(out, name, packed, packedSize);
+    }
+    else
+    {
+        fwrite(packed, 1, packedSize, out);
+    }
+    fclose(out);
+    free(packed);
+    free(data);
+    return 0;
+}
+
+/* Returns the packed size: the big-endian unpacked size, then the blocks */
+static long pack(const unsigned char *data, long size, unsigned char *packed)
+{
+    long packedSize = 0;
+    packed[packedSize++] = (size >> 24) & 0xFF;
+    packed[packedSize++] = (size >> 16) & 0xFF;
+    packed[packedSize++] = (size >> 8) & 0xFF;
+    packed[packedSize++] = size & 0xFF;
+
+    unsigned char block[1 + 8 * 2];
+    int blockSize = 1;
+    int items = 0;
+    block[0] = 0;
+    long position = 0;
+    while (position < size)
+    {
+        int distance;
+        int length;
+        findMatch(data, size, position, &distance, &length);
+        if (length >= MIN_MATCH)
+        {
+            block[blockSize++] = distance - 1;
+            block[blockSize++] = length - MIN_MATCH;
+            position += length;
+        }
+        else
+        {
+            block[0] |= 1 << items;
+            block[blockSize++] = data[position++];
+        }
+        if (++items == 8)
+        {
+            memcpy(packed + packedSize, block, blockSize);
+            packedSize += blockSize;
+            block[0] = 0;
+            blockSize = 1;
+            items = 0;
+        }
+    }
+    if (items != 0)
+    {
+        memcpy(packed + packedSize, block, blockSize);
+        packedSize += blockSize;
+    }
+    return packedSize;
+}
+
+static unsigned char *readFile(const char *path, long *size)
+{
+    FILE *in = fopen(path, "rb");
+    if (in == NULL)
+    {
+        perror(path);
+        return NULL;
+    }
+    fseek(in, 0, SEEK_END);
+    *size = ftell(in);
+    fseek(in, 0, SEEK_SET);
+    unsigned char *data = malloc(*size + 1);
+    if (data == NULL || fread(data, 1, *size, in) != (size_t)*size)
+    {
+        fprintf(stderr, "%s: read failed\n", path);
+        fclose(in);
+        free(data);
+        return NULL;
+    }
+    fclose(in);
+    return data;
+}
+
+static void findMatch(const unsigned char *data, long size, long position, int *distance,
+    int *length)
+{
+    *distance = 0;
+    *length = 0;
+    for (int back = 1; back <= WINDOW_SIZE && back <= position; back++)
+    {
+        int run = 0;
+        while (run < MAX_MATCH && position + run < size
+            && data[position + run] == data[position - back + run])
+        {
+            run++;
+        }
+        if (run > *length)
+        {
+            *distance = back;
+            *length = run;
+        }
+    }
+}
+
+static void writeArray(FILE *out, const char *name, const unsigned char *packed, long size)
+{
+    fprintf(out, "/* Generated by tools/lzpack; do not edit. */\n");
+    fprintf(out, "#include <genesis.h>\n\n");
+    fprintf(out, "const u8 %s[%ld] = {", name, size);
+    for (long i = 0; i < size; i++)
+    {
+        fprintf(out, i % BYTES_PER_LINE == 0 ? "\n    0x%02X," : " 0x%02X,", packed[i]);
+    }
+    fprintf(out, "\n};\n");
+}